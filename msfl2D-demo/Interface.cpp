@@ -7,6 +7,7 @@
 #include "imgui_impl_sdlrenderer2.h"
 
 #include <utility>
+#include <cmath>
 
 namespace Msfl2Demo {
 
@@ -34,6 +35,8 @@ namespace Msfl2Demo {
     int Interface::NB_CREATED = 0;
 
     Interface::Interface(std::shared_ptr<Msfl2D::World> world): world(std::move(world)) {
+        this->world->set_snapshots_enabled(true);
+
         // Only one Interface can exist at a time; we check that.
         if (NB_CREATED > 0) {
             std::cerr << "Tried to create a Interface while one still exists" << std::endl;
@@ -134,19 +137,12 @@ namespace Msfl2Demo {
         // Now we can process the event as it was not consumed by ImGui.
         switch (event->type) {
             case SDL_MOUSEBUTTONDOWN: {
-                if (selected_body == nullptr) {
-                    // Find if a body is hovered. If so, grab it.
-                    for (auto& b: world->get_bodies()) {
-                        if (is_body_hovered(b.second)) {
-                            selected_body = b.second;
-                            selection_pixel_offset = world_to_screen(b.second->get_center()) - get_mouse_pos();
-                            break;
-                        }
-                    }
-                }
+                // The world may be updating, so the hovered body is grabbed before the next update
+                if (selected_body == nullptr) {grab_requested = true;}
             } break;
 
             case SDL_MOUSEBUTTONUP: {
+                grab_requested = false;
                 if (selected_body != nullptr) {
                     selected_body = nullptr;
                 }
@@ -162,7 +158,7 @@ namespace Msfl2Demo {
                 if (event->window.event == SDL_WINDOWEVENT_RESIZED) {
                     int w, h;
                     SDL_GetWindowSize(window, &w, &h);
-                    window_size = {static_cast<double>(w), static_cast<double>(h)};
+                    window_size = {static_cast<real>(w), static_cast<real>(h)};
                 }
             } break;
         }
@@ -204,25 +200,28 @@ namespace Msfl2Demo {
 
 
 
-        // World drawing
+        // World drawing, from the last snapshot, as the next step may be running
         draw_background();
+        auto snapshot = world->get_snapshot();
 
-        // draw collision points
+        // draw collision points. Speculative contacts are not actual collisions.
 
         if (debug_collision_points) {
-            for (int i=0; i<world->nb_collision_points; i++) {
-                draw_point(world->collision_points[i], 5, COLOR_RED);
+            for (auto& c: snapshot->contacts) {
+                if (c.depth < 0) {continue;}
+                for (int i=0; i<c.nb_points; i++) {draw_point(c.points[i], 5, COLOR_RED);}
             }
         }
 
         if (debug_collision_vectors) {
-            for (int i=0; i<world->nb_collision_vectors; i++) {
-                draw_segment(world->collision_vector[i], COLOR_RED);
+            for (auto& c: snapshot->contacts) {
+                if (c.depth <= 0) {continue;}
+                draw_segment(LineSegment(c.points[0], c.points[0] - c.normal * c.depth), COLOR_RED);
             }
         }
 
-        for (auto& b: world->get_bodies()) {
-            draw_body(b);
+        for (auto& b: snapshot->bodies) {
+            draw_body(*snapshot, b);
         }
 
 
@@ -286,8 +285,8 @@ namespace Msfl2Demo {
 
         // Draw points some points along the axis to get a grasp of the size
         for (int i=1; i<4; i++) {
-            draw_point({0, static_cast<double>(i)}, 3, color);
-            draw_point({static_cast<double>(i), 0}, 3, color);
+            draw_point({0, static_cast<real>(i)}, 3, color);
+            draw_point({static_cast<real>(i), 0}, 3, color);
         }
     }
 
@@ -382,66 +381,56 @@ namespace Msfl2Demo {
     }
 
 
-    void Interface::draw_body(const std::pair<BodyID, std::shared_ptr<Msfl2D::Body>>& body_data) const {
-        BodyID body_id = body_data.first;
-        std::shared_ptr<Msfl2D::Body> body = body_data.second;
-        bool hovered = is_body_hovered(body);
-        for (auto& s: body->get_shapes()) {
-            // Choose the correct drawing method based on the shape and if it is hovered or not
-            if (hovered) {
-                auto as_convex = std::dynamic_pointer_cast<ConvexPolygon>(s);
-                if (as_convex != nullptr) {
-                    draw_polygon_filled(*as_convex);
-                    if (debug_centers) {draw_point(as_convex->get_position());}
-                    continue;
-                }
-            }
-            else {
-                auto as_convex = std::dynamic_pointer_cast<ConvexPolygon>(s);
-                if (as_convex != nullptr) {
-                    draw_polygon_outline(*as_convex);
-                    if (debug_centers) {draw_point(as_convex->get_position());}
-                    continue;
-                }
+    void Interface::draw_body(const WorldSnapshot& snapshot, const BodySnapshot& body) const {
+        bool hovered = body.id == hovered_body;
+        for (int i=body.first_shape; i<body.first_shape + body.nb_shapes; i++) {
+            const ShapeSnapshot& s = snapshot.shapes[i];
+
+            // Only polygons have vertices, so exit the program for the other shapes
+            if (s.nb_vertices == 0) {
+                std::cerr << "World contains an unknown/undrawable shape type" << std::endl;
+                exit(EXIT_FAILURE);
             }
-            // Unknown type so exit program
-            // (on drawing success, the loop should have continued by now)
-            std::cerr << "World contains an unknown/undrawable shape type" << std::endl;
-            exit(EXIT_FAILURE);
+
+            // Choose the drawing method based on if the body is hovered or not
+            const Vec2D* vertices = &snapshot.vertices[s.first_vertex];
+            if (hovered) {draw_polygon_filled(vertices, s.nb_vertices, s.position);}
+            else {draw_polygon_outline(vertices, s.nb_vertices);}
+            if (debug_centers) {draw_point(s.position);}
         }
 
         if (debug_centers) {
-            draw_point(body->get_center(), 3, COLOR_YELLOW);
+            draw_point(body.position, 3, COLOR_YELLOW);
         }
         if (debug_bodyids) {
-            std::string text = "id: " + std::to_string(body_id);
-            draw_text(text.c_str(), body->get_center(), COLOR_YELLOW);
+            std::string text = "id: " + std::to_string(body.id);
+            draw_text(text.c_str(), body.position, COLOR_YELLOW);
         }
         if (debug_velocities) {
-            if (body->velocity.norm() > 0) {
-                LineSegment vel_vec = {body->get_center(), body->get_center() + body->velocity};
+            if (body.velocity.norm() > 0) {
+                LineSegment vel_vec = {body.position, body.position + body.velocity};
                 draw_segment(vel_vec, COLOR_YELLOW);
             }
-            std::string text = "vel: " + std::to_string(body->velocity.norm());
-            draw_text(text.c_str(), body->get_center(), COLOR_YELLOW);
+            std::string text = "vel: " + std::to_string(body.velocity.norm());
+            draw_text(text.c_str(), body.position, COLOR_YELLOW);
         }
         if (debug_collision_number) {
-            std::string text = "col num: " + std::to_string(body->get_nb_collisions());
-            draw_text(text.c_str(), body->get_center(), COLOR_YELLOW);
+            std::string text = "col num: " + std::to_string(body.nb_collisions);
+            draw_text(text.c_str(), body.position, COLOR_YELLOW);
         }
         if (debug_mass) {
-            std::string text = "mass: " + std::to_string(body->get_mass());
-            draw_text(text.c_str(), body->get_center(), COLOR_YELLOW);
+            std::string text = "mass: " + std::to_string(body.mass);
+            draw_text(text.c_str(), body.position, COLOR_YELLOW);
         }
     }
 
 
-    void Interface::draw_polygon_outline(const ConvexPolygon &p, const Color4 &color) const {
+    void Interface::draw_polygon_outline(const Vec2D* vertices, int nb_vertices, const Color4 &color) const {
         set_color(color);
 
-        for (int i=0; i<p.nb_vertices(); i++) {
-            Vec2D p1 = world_to_screen(p.get_global_vertex(i));
-            Vec2D p2 = world_to_screen(p.get_global_vertex((i+1) % p.nb_vertices()));
+        for (int i=0; i<nb_vertices; i++) {
+            Vec2D p1 = world_to_screen(vertices[i]);
+            Vec2D p2 = world_to_screen(vertices[(i+1) % nb_vertices]);
 
             int r = SDL_RenderDrawLine(renderer, p1.x, p1.y, p2.x, p2.y);
             if (r != 0) {sdl_failure();}
@@ -449,13 +438,13 @@ namespace Msfl2Demo {
     }
 
 
-    void Interface::draw_polygon_filled(const ConvexPolygon &p, const Color4 &color) const {
-        draw_polygon_outline(p);
+    void Interface::draw_polygon_filled(const Vec2D* vertices, int nb_vertices, const Vec2D& center, const Color4 &color) const {
+        draw_polygon_outline(vertices, nb_vertices);
 
         // This function uses SDL_RenderGeometry to draw the filled polygon.
         set_color(color);
 
-        Vec2D p_center = world_to_screen(p.get_position());
+        Vec2D p_center = world_to_screen(center);
         SDL_Vertex center_vertex = {
                 static_cast<float>(p_center.x),
                 static_cast<float>(p_center.y),
@@ -467,11 +456,11 @@ namespace Msfl2Demo {
         // Convert from Msfl data to SDL data
         // probably not the most efficient mesh, as for each vertex we created a triangle
         // with the vertex, the center and the next vertex
-        SDL_Vertex sdl_vertices[p.nb_vertices()*3];
+        SDL_Vertex sdl_vertices[nb_vertices*3];
 
-        for (int i=0; i<p.nb_vertices(); i++) {
-            Vec2D current_v = world_to_screen(p.get_global_vertex(i));
-            Vec2D next_v = world_to_screen(p.get_global_vertex((i+1) % p.nb_vertices()));
+        for (int i=0; i<nb_vertices; i++) {
+            Vec2D current_v = world_to_screen(vertices[i]);
+            Vec2D next_v = world_to_screen(vertices[(i+1) % nb_vertices]);
 
             sdl_vertices[i*3] = {
                     static_cast<float>(current_v.x),
@@ -491,7 +480,7 @@ namespace Msfl2Demo {
         }
 
         // Draw the polygon
-        int r = SDL_RenderGeometry(renderer, nullptr, sdl_vertices, p.nb_vertices()*3, nullptr, 0);
+        int r = SDL_RenderGeometry(renderer, nullptr, sdl_vertices, nb_vertices*3, nullptr, 0);
         if (r != 0) {sdl_failure();}
     }
 
@@ -529,7 +518,7 @@ namespace Msfl2Demo {
         ImGui::SameLine();
         ImGui::PushItemWidth(75);
         if (ImGui::InputInt2("##", cam_pos)) {
-            camera_pos = {static_cast<double>(cam_pos[0]), static_cast<double>(cam_pos[1])};
+            camera_pos = {static_cast<real>(cam_pos[0]), static_cast<real>(cam_pos[1])};
         }
         ImGui::SameLine();
         if (ImGui::Button("Reset##camera")) {camera_pos = {0, 0};}
@@ -564,37 +553,38 @@ namespace Msfl2Demo {
 
 
     void Interface::update(double delta_t) {
+        // The grabbed body can only be moved once the last update is done
+        if (pending_update.valid()) {pending_update.get();}
+        update_hovering();
         update_grabbing();
-        world->update(delta_t);
+        pending_update = world->update_async(delta_t);
     }
 
 
 
-    void Interface::update_grabbing() {
-        if (selected_body != nullptr) {
-            selected_body->angular_vel = 0;
-            selected_body->velocity = {0,0};
-            selected_body->move(screen_to_world(get_mouse_pos() + selection_pixel_offset));
-        }
+    void Interface::update_hovering() {
+        BodyID ids[1];
+        hovered_body = world->query_point(screen_to_world(get_mouse_pos()), ids, 1) > 0 ? ids[0] : 0;
     }
 
-    bool Interface::is_body_hovered(const std::shared_ptr<Body>& body) const {
-        bool hovered = false;
-        Vec2D mouse_pos = screen_to_world(get_mouse_pos());
-        for (auto& s: body->get_shapes()) {
-            if (s->is_point_inside(mouse_pos)) {
-                hovered = true;
-                break;
-            }
+    void Interface::update_grabbing() {
+        if (grab_requested && hovered_body != 0) {
+            selected_body = world->get_body(hovered_body);
+            selection_pixel_offset = world_to_screen(selected_body->get_center()) - get_mouse_pos();
         }
+        grab_requested = false;
 
-        return hovered;
+        if (selected_body != nullptr) {
+            selected_body->set_angular_velocity(0);
+            selected_body->set_velocity({0,0});
+            selected_body->move(screen_to_world(get_mouse_pos() + selection_pixel_offset));
+        }
     }
 
     void Interface::create_world_info_window() {
         ImGui::SetNextWindowSize({160.0, 0.0});
         ImGui::Begin("World informations", nullptr, IMGUI_WINDOW_FLAGS);
-        ImGui::Text("Body count: %d", world->nb_bodies());
+        ImGui::Text("Body count: %d", static_cast<int>(world->get_snapshot()->bodies.size()));
         ImGui::End();
 
     }
@@ -6,11 +6,13 @@
 #define MSFL2D_INTERFACE_HPP
 
 #include <memory>
+#include <future>
 
 #include <SDL2/SDL.h>
 #include <SDL_ttf.h>
 
 #include "msfl2D/World.hpp"
+#include "msfl2D/WorldSnapshot.hpp"
 
 #include "Color4.hpp"
 #include "msfl2D/ConvexPolygon.hpp"
@@ -34,7 +36,7 @@ namespace Msfl2Demo {
 
         /**
          * Create a new Interface. The renderer will not be creating a window yet. For that,
-         * call init_window().
+         * call init_window(). The snapshots of the world are enabled, as the Interface draws them.
          */
         explicit Interface(std::shared_ptr<World> world);
 
@@ -89,7 +91,8 @@ namespace Msfl2Demo {
         void process_io();
 
         /**
-         * Update the world
+         * Wait for the last update of the world, then start the next one in the background. The world can be
+         * rendered in the meantime, from its last snapshot.
          */
         void update(double delta_t);
 
@@ -97,8 +100,8 @@ namespace Msfl2Demo {
 
 
         // Drawing methods
-        /** Draw the given body */
-        void draw_body(const std::pair<BodyID, std::shared_ptr<Msfl2D::Body>>& body_data) const;
+        /** Draw the given body of a snapshot */
+        void draw_body(const WorldSnapshot& snapshot, const BodySnapshot& body) const;
         /** Draw background info (axis, etc.) */
         void draw_background(const Color4& color = BACKGROUND_INFO_COLOR) const;
         /** Draw a line */
@@ -107,10 +110,10 @@ namespace Msfl2Demo {
         void draw_segment(const LineSegment& segment, const Color4& color = COLOR_YELLOW) const;
         /** Draw a point */
         void draw_point(const Vec2D& point, int size = 3, const Color4& color = COLOR_BLUE) const;
-        /** Draw a ConvexPolygon outline */
-        void draw_polygon_outline(const ConvexPolygon& polygon, const Color4& color = SHAPE_OUTLINE_COLOR) const;
-        /** Draw a filled ConvexPolygon */
-        void draw_polygon_filled(const ConvexPolygon& polygon, const Color4& color = SHAPE_AREA_COLOR) const;
+        /** Draw the outline of a convex polygon, given its world-space vertices */
+        void draw_polygon_outline(const Vec2D* vertices, int nb_vertices, const Color4& color = SHAPE_OUTLINE_COLOR) const;
+        /** Draw a filled convex polygon, given its world-space vertices & its center */
+        void draw_polygon_filled(const Vec2D* vertices, int nb_vertices, const Vec2D& center, const Color4& color = SHAPE_AREA_COLOR) const;
         /** Write a line of text, with the top-left corner of the textzone at the given (world-space) location */
         void draw_text(const char* text, const Vec2D& pos, const Color4& color = COLOR_YELLOW) const;
 
@@ -136,9 +139,15 @@ namespace Msfl2Demo {
         std::string window_name;
         Vec2D window_size;
 
-        // Used to manage grabbing and moving bodies.
+        // Used to manage grabbing and moving bodies. The hovered body is found between the updates of the world,
+        // and a click only requests to grab it, as the world may be updating when the click is processed.
         std::shared_ptr<Body> selected_body;
         Vec2D selection_pixel_offset = {0, 0};
+        BodyID hovered_body = 0;
+        bool grab_requested = false;
+
+        // Update of the world running in the background
+        std::future<void> pending_update;
 
         /**
          * World-space of the center of the camera (i.e center of the screen).
@@ -187,16 +196,17 @@ namespace Msfl2Demo {
 
 
         // Methods used to update the World.
+        /**
+         * Find the body under the mouse.
+         */
+        void update_hovering();
+
         /**
          * Manage grabbing & dropping bodies.
          */
         void update_grabbing();
 
 
-
-        [[nodiscard]] bool is_body_hovered(const std::shared_ptr<Body>& body) const;
-
-
         /**
          * Return the world-space position of the top-left and bottom-right corners of the screen.
          */
@@ -3,6 +3,7 @@
 //
 
 #include <iostream>
+#include <cmath>
 #include <SDL2/SDL.h>
 #include <SDL_ttf.h>
 
@@ -67,23 +68,23 @@ int main(int argc, char *argv[]) {
 
     // Floor
     std::shared_ptr<ConvexPolygon> floor = std::make_shared<ConvexPolygon>(ConvexPolygon({{-20, 0}, {20, 0}, {20, -1}, {-20, -1}}));
-    std::shared_ptr<Body> body_floor = std::make_shared<Body>(Body());
+    std::shared_ptr<Body> body_floor = std::make_shared<Body>();
     body_floor->add_shape(floor);
-    body_floor->is_static = true;
+    body_floor->set_static(true);
     //body_floor->set_bounciness(0.1);
 
 
     // triangle
     /*std::shared_ptr<ConvexPolygon> shape_1 = std::make_shared<ConvexPolygon>(ConvexPolygon(3, 3, {-20, 1.5}));
-    std::shared_ptr<Body> body_1 = std::make_shared<Body>(Body());
+    std::shared_ptr<Body> body_1 = std::make_shared<Body>();
     body_1->add_shape(shape_1);
-    body_1->is_static = true;
+    body_1->set_static(true);
     body_1->rotate(M_PI / 2);
     body_floor->set_bounciness(0.1);*/
 
     // square
     std::shared_ptr<ConvexPolygon> shape_2 = std::make_shared<ConvexPolygon>(ConvexPolygon(4, 1, {-4, 100}));
-    std::shared_ptr<Body> body_2 = std::make_shared<Body>(Body());
+    std::shared_ptr<Body> body_2 = std::make_shared<Body>();
     body_2->add_shape(shape_2);
     body_2->rotate(M_PI / 4);
     body_2->set_mass(50);
@@ -91,7 +92,7 @@ int main(int argc, char *argv[]) {
 
     // square
     std::shared_ptr<ConvexPolygon> shape_3 = std::make_shared<ConvexPolygon>(ConvexPolygon(4, 3, {-4, 3}));
-    std::shared_ptr<Body> body_3 = std::make_shared<Body>(Body());
+    std::shared_ptr<Body> body_3 = std::make_shared<Body>();
     body_3->add_shape(shape_3);
     body_3->rotate(M_PI / 4);
     body_3->set_mass(50);
@@ -99,7 +100,7 @@ int main(int argc, char *argv[]) {
 
     // square
     std::shared_ptr<ConvexPolygon> shape_4 = std::make_shared<ConvexPolygon>(ConvexPolygon(4, 5, {4, 100}));
-    std::shared_ptr<Body> body_4 = std::make_shared<Body>(Body());
+    std::shared_ptr<Body> body_4 = std::make_shared<Body>();
     body_4->add_shape(shape_4);
     body_4->rotate(M_PI / 4);
     body_4->set_mass(50);
@@ -107,7 +108,7 @@ int main(int argc, char *argv[]) {
 
 
 
-    std::shared_ptr<World> world = std::make_shared<World>(World());
+    std::shared_ptr<World> world = std::make_shared<World>();
     world->add_body(body_floor);
     //world->add_body(body_1);
     world->add_body(body_2);
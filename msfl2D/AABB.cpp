@@ -0,0 +1,47 @@
+//
+// Created by myselfleo on 14/07/2023.
+//
+
+#include <algorithm>
+
+#include "AABB.hpp"
+
+namespace Msfl2D {
+    AABB::AABB(const Vec2D &p1, const Vec2D &p2) {
+        min = {std::min(p1.x, p2.x), std::min(p1.y, p2.y)};
+        max = {std::max(p1.x, p2.x), std::max(p1.y, p2.y)};
+    }
+
+    bool AABB::overlap(const AABB &b1, const AABB &b2) {
+        // Two boxes overlap if they overlap on both axis
+        if (b1.max.x < b2.min.x || b2.max.x < b1.min.x) {return false;}
+        if (b1.max.y < b2.min.y || b2.max.y < b1.min.y) {return false;}
+        return true;
+    }
+
+    AABB AABB::merge(const AABB &b1, const AABB &b2) {
+        AABB res;
+        res.min = {std::min(b1.min.x, b2.min.x), std::min(b1.min.y, b2.min.y)};
+        res.max = {std::max(b1.max.x, b2.max.x), std::max(b1.max.y, b2.max.y)};
+        return res;
+    }
+
+    AABB AABB::expanded(const Vec2D &displacement) const {
+        AABB res = *this;
+        // Only the side in the direction of the displacement needs to grow.
+        if (displacement.x < 0) {res.min.x += displacement.x;}
+        else {res.max.x += displacement.x;}
+        if (displacement.y < 0) {res.min.y += displacement.y;}
+        else {res.max.y += displacement.y;}
+        return res;
+    }
+
+    bool AABB::has(const Vec2D &p) const {
+        return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y;
+    }
+
+    std::ostream &operator<<(std::ostream &os, const AABB &box) {
+        os << "[" << box.min << ", " << box.max << "]";
+        return os;
+    }
+} // Msfl2D
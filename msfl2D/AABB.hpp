@@ -0,0 +1,54 @@
+//
+// Created by myselfleo on 14/07/2023.
+//
+
+#ifndef MSFL2D_AABB_HPP
+#define MSFL2D_AABB_HPP
+
+#include "Vec2D.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * An Axis-Aligned Bounding Box, represented by its bottom-left (min) and top-right (max) corners.
+     * AABBs are used to quickly discard pairs of shapes that cannot collide before running the costly SAT test.
+     */
+    class AABB {
+    public:
+        Vec2D min;
+        Vec2D max;
+
+        /** Default constructor, creates an empty box at (0, 0) */
+        AABB() = default;
+
+        /** Base constructor. The corners are sorted so min is always the bottom-left one. */
+        AABB(const Vec2D& p1, const Vec2D& p2);
+
+        /**
+         * Return whether the 2 boxes are overlapping. Boxes that are only touching are considered overlapping.
+         */
+        static bool overlap(const AABB& b1, const AABB& b2);
+
+        /**
+         * Return the smallest box containing both of the given boxes.
+         */
+        static AABB merge(const AABB& b1, const AABB& b2);
+
+        /**
+         * Return the box swept by this box when it moves by the given displacement, i.e. the union of this box
+         * and this box translated by the displacement.
+         */
+        AABB expanded(const Vec2D& displacement) const;
+
+        /**
+         * Return whether the given point is inside the box (or on its border).
+         */
+        bool has(const Vec2D& p) const;
+
+        // std::cout operators
+        friend std::ostream& operator<<(std::ostream& os, const AABB& box);
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_AABB_HPP
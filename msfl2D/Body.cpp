@@ -3,39 +3,147 @@
 //
 
 #include "Body.hpp"
+#include "Joint.hpp"
 #include "MsflExceptions.hpp"
 
 #include <memory>
 #include <cmath>
 
 namespace Msfl2D {
+    Body::Body():
+        own_storage(std::make_unique<BodyStorage>())
+        {
+        storage = own_storage.get();
+        index = storage->add(this);
+    }
+
+    Body::Body(BodyStorage &world_storage):
+        storage(&world_storage)
+        {
+        index = storage->add(this);
+    }
+
+    Body::~Body() {
+        // A body is destroyed once no World owns it anymore, so its row is in its own storage or already released
+        if (storage != nullptr && storage != own_storage.get()) {storage->remove(index);}
+
+        // The shapes may outlive the body
+        for (auto& s: shapes) {s->body = nullptr;}
+        release_shapes();
+    }
+
+
+    void Body::attach(BodyStorage &new_storage) {
+        int new_index = new_storage.add(this);
+        BodyStorage::copy_row(*storage, index, new_storage, new_index);
+        for (auto& s: shapes) {s->attach(new_storage.vertices);}
+
+        if (storage != own_storage.get()) {storage->remove(index);}
+        own_storage.reset();
+
+        storage = &new_storage;
+        index = new_index;
+    }
+
+    void Body::detach() {
+        if (storage == own_storage.get()) {return;}
+
+        own_storage = std::make_unique<BodyStorage>();
+        int new_index = own_storage->add(this);
+        BodyStorage::copy_row(*storage, index, *own_storage, new_index);
+        for (auto& s: shapes) {s->attach(own_storage->vertices);}
+        storage->remove(index);
+
+        storage = own_storage.get();
+        index = new_index;
+    }
+
+
+    void Body::release() {
+        if (storage == own_storage.get()) {return;}
+        release_shapes();
+        storage->remove(index);
+        storage = nullptr;
+    }
+
+    void Body::release_shapes() {
+        // The shapes only referenced by the body are destroyed with it, the others keep their vertices
+        for (auto& s: shapes) {
+            if (s.use_count() == 1) {s->release();}
+            else {s->detach();}
+        }
+    }
+
+
     Body& Body::add_shape(const std::shared_ptr<Shape>& shape) {
+        if (shape->body != nullptr) {throw GeometryException("Tried to add a shape already owned by a body");}
         shapes.push_back(shape);
-        shape->body = shared_from_this();
-        update_center();
+        shape->body = this;
+        shape->attach(storage->vertices);
+        update_mass_properties();
+        storage->version++;
         return *this;
     }
 
     Vec2D Body::get_center() const {
-        return position;
+        return storage->positions[index];
+    }
+
+
+    AABB Body::get_aabb() const {
+        if (shapes.empty()) {throw GeometryException("Cannot compute the bounding box of a body without shape");}
+
+        AABB res = shapes[0]->get_aabb();
+        for (int i=1; i<shapes.size(); i++) {
+            res = AABB::merge(res, shapes[i]->get_aabb());
+        }
+        return res;
     }
 
 
-    void Body::update_center() {
-        // get sum of shapes global position
+    void Body::update_mass_properties() {
+        if (shapes.empty()) {
+            inertia = 0;
+            storage->inv_inertias[index] = 0;
+            storage->inv_masses[index] = is_dynamic() ? 1 / mass : 0;
+            return;
+        }
+
+        // The center of the body is the average of the shape centroids, weighted by their area.
+        real total_area = 0;
         Vec2D new_center = {0,0};
         for (auto& s: shapes) {
-            new_center += s->position;
+            total_area += s->area;
+            new_center += s->get_centroid() * s->area;
         }
+        Vec2D& position = storage->positions[index];
+        position = new_center / total_area;
 
-        // average them
-        new_center /= shapes.size();
-        position = new_center;
+        // The mass of the body is distributed uniformly over its shapes, so its moment of inertia is the sum of the
+        // inertia of each shape, moved to the body center (parallel axis theorem), times the density.
+        real density = mass / total_area;
+        inertia = 0;
+        for (auto& s: shapes) {
+            inertia += (s->inertia + s->area * Vec2D::distance_squared(s->get_centroid(), position)) * density;
+        }
+
+        if (is_dynamic()) {
+            storage->inv_masses[index] = 1 / mass;
+            storage->inv_inertias[index] = inertia > 0 ? 1 / inertia : 0;
+        }
+        else {
+            storage->inv_masses[index] = 0;
+            storage->inv_inertias[index] = 0;
+        }
     }
 
     void Body::remove_shape(int idx) {
         if (idx > shapes.size() - 1) {throw GeometryException("Tried to remove an inexistant shape");}
+        shapes[idx]->body = nullptr;
+        shapes[idx]->detach();
         shapes.erase(shapes.begin() + idx);
+        update_mass_properties();
+        storage->version++;
     }
 
     std::shared_ptr<Shape> Body::get_shape(int idx) {
@@ -49,126 +157,210 @@ namespace Msfl2D {
 
     void Body::move_shape(int idx, Vec2D pos) {
         if (idx > shapes.size() - 1) {throw GeometryException("Tried to update an inexistant shape");}
-        shapes[idx]->position = pos;
-        update_center();
+        shapes[idx]->transform.translation = pos;
+        shapes[idx]->transform_changed();
+        update_mass_properties();
+        storage->version++;
     }
 
     void Body::move(Vec2D pos) {
         // Compute the displacement; we'll add it to each shape position so they move the same way.
         // That way, the center of the body will be exactly where we want it.
-        Vec2D displacement = pos - position;
+        Vec2D displacement = pos - storage->positions[index];
 
         for (auto& s: shapes) {
-            s->position += displacement;
+            s->transform.translation += displacement;
+            s->transform_changed();
         }
 
-        position = pos;
+        storage->positions[index] = pos;
+        storage->version++;
     }
 
-    void Body::rotate_shape(int idx, double angle) {
+    void Body::rotate_shape(int idx, real angle) {
         if (idx > shapes.size() - 1) {throw GeometryException("Tried to update an inexistant shape");}
 
-        // prevent overflow of rotation value
-        if (angle > (M_PI * 2)) {angle -= M_PI * 2;}
-        if (angle < (M_PI * -2)) {angle += M_PI * 2;}
-
-        shapes[idx]->rotation = angle;
+        shapes[idx]->transform.rotation = Rotor2D(angle);
+        shapes[idx]->transform_changed();
+        update_mass_properties();
+        storage->version++;
     }
 
 
-    void Body::rotate(double angle) {
-        rotate(angle, position);
+    void Body::rotate(real angle) {
+        rotate(angle, get_center());
     }
 
 
-    void Body::rotate(double angle, const Vec2D &center) {
+    void Body::rotate(real angle, const Vec2D &center) {
+        Rotor2D r(angle);
+
+        // rotate the vertices of the shapes around the shape centers, and the shape centers around the specified point
         for (auto& s: shapes) {
-            s->rotation += angle;                            // rotate the vertices of the shapes around the shape centers
+            s->transform.rotate(r, center);
+            s->transform_changed();
+        }
+
+        // Rotating the whole body doesn't change its moment of inertia; only its center may move.
+        Vec2D& position = storage->positions[index];
+        position = r.rotate(position - center) + center;
 
-            // prevent overflow of rotation value
-            if (s->rotation > (M_PI * 2)) {s->rotation -= M_PI * 2;}
-            if (s->rotation < (M_PI * -2)) {s->rotation += M_PI * 2;}
+        Rotor2D& rotation = storage->rotations[index];
+        rotation = (r * rotation).normalized();
+        storage->version++;
+    }
 
+    void Body::transform_shapes(const Vec2D &displacement, const Rotor2D& rotation) {
+        const Vec2D& center = storage->positions[index];
 
-            s->position = s->position.rotate(angle, center); // rotate the center of the shapes around the specified point
+        for (auto& s: shapes) {
+            s->transform.translation += displacement;
+            if (!rotation.is_identity()) {s->transform.rotate(rotation, center);}
+            s->transform_changed();
         }
-        update_center();
     }
 
+    real Body::get_rotation() const {return storage->rotations[index].angle();}
 
-    void Body::reset_forces() {forces.clear();}
-    void Body::register_force(Vec2D force) {
-        if (is_static) {return;}
-        forces.emplace_back(force * get_mass(), Vec2D(0, 0));
-    }
-    void Body::register_force(Vec2D force, Vec2D application_point) {
-        if (is_static) {return;}
-        forces.emplace_back(force, application_point);
-    }
+    Transform2D Body::get_transform() const {return {storage->positions[index], storage->rotations[index]};}
 
 
-    void Body::apply_forces(double delta_t) {
-        // apply each forces, modifying velocity & inertia
-        for (auto& f: forces) {
-            Vec2D force = std::get<0>(f);
-            Vec2D point_of_application = std::get<1>(f);
+    Vec2D Body::get_velocity() const {return storage->velocities[index];}
 
-            velocity += force * delta_t / get_mass();
+    void Body::set_velocity(const Vec2D &v) {storage->velocities[index] = v;}
 
+    real Body::get_angular_velocity() const {return storage->angular_velocities[index];}
 
-            if (point_of_application != get_center()) {
-                // compute angular velocity
-                double torque = Vec2D::cross(force, -point_of_application);
+    void Body::set_angular_velocity(real w) {storage->angular_velocities[index] = w;}
 
-                // moment of inertia. Lets assume its a circle. // todo: maybe really compute this ?
-                // lets compute the moment of inertia of a circle that has the same mass and density as the body
-                //todo: replace mass by area when we'll compute it (to compute mass using density)
-                double fallacious_circle_radius = sqrt(get_mass() / M_PI);
-                double moment_inertia = M_PI * pow(fallacious_circle_radius, 4) / 4;
-                double angular_acceleration = torque / moment_inertia;
 
-                //angular_vel += angular_acceleration * delta_t;
-            }
-        }
+    void Body::reset_forces() {
+        storage->forces[index] = {0, 0};
+        storage->torques[index] = 0;
+    }
+    void Body::register_force(Vec2D f) {
+        if (!is_dynamic()) {return;}
+        storage->forces[index] += f * mass;
+    }
+    void Body::register_force(Vec2D f, Vec2D application_point) {
+        if (!is_dynamic()) {return;}
+        storage->forces[index] += f;
+        storage->torques[index] += Vec2D::cross(application_point, f);
+    }
+
+
+    void Body::apply_forces(real delta_t, const Vec2D& acceleration) {
+        if (!is_dynamic()) {return;}
 
+        // apply the registered forces & the given acceleration, modifying velocity & angular velocity
+        storage->velocities[index] += (storage->forces[index] * get_inv_mass() + acceleration) * delta_t;
+        storage->angular_velocities[index] += storage->torques[index] * get_inv_inertia() * delta_t;
+    }
+
+    void Body::apply_impulse(const Vec2D &impulse, const Vec2D &application_point) {
+        // The inverses of the mass & inertia are 0 for static & kinematic bodies, so they won't be affected.
+        storage->velocities[index] += impulse * get_inv_mass();
+        storage->angular_velocities[index] += Vec2D::cross(application_point, impulse) * get_inv_inertia();
+    }
+
+    void Body::integrate(real delta_t) {
         // apply velocity & inertia
-        move(position + (velocity * delta_t));
+        move(get_center() + (get_velocity() * delta_t));
 
         // apply angular velocity
-        rotate(angular_vel * delta_t);
+        real angular_vel = get_angular_velocity();
+        if (angular_vel != 0) {rotate(angular_vel * delta_t);}
+    }
+
+    bool Body::is_connected(const Body &other) const {
+        for (auto& j: joints) {
+            if (j->get_body1().get() == &other || j->get_body2().get() == &other) {return true;}
+        }
+        return false;
     }
 
-    double Body::get_bounciness() const {
+    real Body::get_bounciness() const {
         return bounciness;
     }
 
-    void Body::set_bounciness(double b) {
+    void Body::set_bounciness(real b) {
         if (b < 0 || b > 1) {throw SimulationException("The bounciness must be a number between 0 & 1.");}
         bounciness = b;
     }
 
-    void Body::set_mass(double m) {
-        if (is_static) {this->mass = 0;}
-        else {this->mass = m;}
+    bool Body::is_static() const {return storage->types[index] == BodyType::STATIC;}
+
+    void Body::set_static(bool s) {
+        if (s) {storage->types[index] = BodyType::STATIC;}
+        else if (is_static()) {storage->types[index] = BodyType::DYNAMIC;}
+        update_mass_properties();
+    }
+
+    bool Body::is_kinematic() const {return storage->types[index] == BodyType::KINEMATIC;}
+
+    void Body::set_kinematic(bool k) {
+        if (k) {storage->types[index] = BodyType::KINEMATIC;}
+        else if (is_kinematic()) {storage->types[index] = BodyType::DYNAMIC;}
+        update_mass_properties();
     }
 
-    double Body::get_mass() const {
-        if (is_static) {return 0;}
+    bool Body::is_dynamic() const {return storage->types[index] == BodyType::DYNAMIC;}
+
+    void Body::set_mass(real m) {
+        if (m <= 0) {throw SimulationException("The mass must be a number > 0.");}
+        mass = m;
+        update_mass_properties();
+    }
+
+    real Body::get_mass() const {
+        if (!is_dynamic()) {return 0;}
         return mass;
     }
 
-    void Body::set_friction(double f) {
+    real Body::get_inv_mass() const {return storage->inv_masses[index];}
+
+    real Body::get_inertia() const {
+        if (!is_dynamic()) {return 0;}
+        return inertia;
+    }
+
+    real Body::get_inv_inertia() const {return storage->inv_inertias[index];}
+
+    void Body::set_friction(real f) {
         if (f < 0 || f > 1) {throw SimulationException("The friction must be a number between 0 & 1.");}
         friction = f;
     }
 
-    double Body::get_friction() const {
+    real Body::get_friction() const {
         return friction;
     }
 
+    std::uint32_t Body::get_collision_category() const {
+        return collision_category;
+    }
+
+    void Body::set_collision_category(std::uint32_t category) {
+        collision_category = category;
+
+        // The spatial queries keep the categories of the shapes
+        storage->version++;
+    }
+
+    std::uint32_t Body::get_collision_mask() const {
+        return collision_mask;
+    }
+
+    void Body::set_collision_mask(std::uint32_t mask) {
+        collision_mask = mask;
+    }
+
+    bool Body::can_collide(const Body &other) const {
+        return (collision_category & other.collision_mask) != 0 && (other.collision_category & collision_mask) != 0;
+    }
+
     Vec2D Body::get_point_angular_velocity(const Vec2D &point) const {
-        double radius = point.norm();
-        double tangential_speed = radius * angular_vel;
+        real radius = point.norm();
+        real tangential_speed = radius * get_angular_velocity();
         Vec2D tangent = Vec2D(-point.y, point.x).normalized();
 
         return tangent * tangential_speed;
@@ -177,11 +369,7 @@ namespace Msfl2D {
 
     Vec2D Body::get_point_angular_momentum(const Vec2D &point) const {
 
-        // Lets consider the body as a circle (moment of inertia: 1/2 m R²)
-        double radius = point.norm();
-        double moment_inertia = 0.5 * get_mass() * radius * radius;
-
-        return get_point_angular_velocity(point) * moment_inertia;
+        return get_point_angular_velocity(point) * get_inertia();
     }
 
 
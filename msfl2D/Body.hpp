@@ -6,49 +6,137 @@
 #define MSFL2D_BODY_HPP
 
 #include "Shape.hpp"
+#include "BodyStorage.hpp"
 
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 namespace Msfl2D {
 
+    /**
+     * Identifier of a body in a World. The lower 32 bits are the index of the slot of the body in the World, and the
+     * higher 32 bits the generation of that slot: the generation is incremented when the body is removed, so the ID
+     * of a removed body never refers to the body later added in the same slot. A valid ID is never 0.
+     */
+    typedef std::uint64_t BodyID;
+
+    // pre-declare joint, as joints refer to bodies too
+    class Joint;
+
 
     /**
      * A body is a simulation element with specific parameters (position, speed, mass, etc.).
+     *
+     * The values used at each simulation step (position, velocity, inverse mass, etc.) are not stored in the body
+     * itself, but in a row of a BodyStorage: the one of the World once the body is added to it, or a storage of its
+     * own before that. The body is a handle to that row.
      */
-    class Body: public std::enable_shared_from_this<Body> {
+    class Body {
     public:
+        /** Collision mask matching every category, used by default */
+        static constexpr std::uint32_t ALL_CATEGORIES = 0xFFFFFFFF;
+
         /**
-         * Velocity vector, in units per second
+         * Create a body with no shape. Its position will be set to (0, 0), but it's useless as it will update
+         * when adding a shape.
+         *
+         * Until it is added to a World, the body has a BodyStorage of its own, holding its single row: creating it
+         * allocates the storage and one element in each of its arrays (about a dozen small allocations), and adding
+         * it to a World copies the row and frees them. Those allocations belong to the user, and are not counted by
+         * World::memory_stats(). To create many bodies, use World::create_body() or World::create_bodies() instead,
+         * which create the bodies directly in the storage of the world, from its memory pool.
          */
-        Vec2D velocity = {0, 0};
+        Body();
+
+        ~Body();
+
+        // The body is a handle to a row of a storage, which can't be shared
+        Body(const Body&) = delete;
+        Body& operator=(const Body&) = delete;
+
 
         /**
-         * Angular velocity, in radians per second
+         * Return the center of the body, in world-space coordinates. This is its {0, 0} relative position.
+         * It is the center of mass of its shapes.
          */
-        double angular_vel = 0;
+        Vec2D get_center() const;
+
 
         /**
-         * Bodies can be made static, which mean they won't be affected by any forces. To move them, use move() instead
-         * of applying forces to it.
+         * Return the rotation of the body, in radians, in [-pi, pi]. This is the sum of the rotations applied to the
+         * whole body (see rotate()), and it is 0 when the body is created.
          */
-        bool is_static = false;
+        real get_rotation() const;
 
         /**
-         * Create a body with no shape. Its position will be set to (0, 0), but it's useless as it will update
-         * when adding a shape.
+         * Return the transform of the body, converting body-space coordinates (relative to its center & without its
+         * rotation) into world-space coordinates.
          */
-        Body() = default;
+        Transform2D get_transform() const;
 
 
         /**
-         * Remove the center of the body, in world-space coordinates. This is its {0, 0} relative position.
+         * Return the velocity vector, in units per second
          */
-        Vec2D get_center() const;
+        Vec2D get_velocity() const;
+
+        /**
+         * Set the velocity vector, in units per second
+         */
+        void set_velocity(const Vec2D& v);
+
+        /**
+         * Return the angular velocity, in radians per second
+         */
+        real get_angular_velocity() const;
+
+        /**
+         * Set the angular velocity, in radians per second
+         */
+        void set_angular_velocity(real w);
+
+
+        /**
+         * Return whether the body is static. Static bodies won't be affected by any forces. To move them,
+         * use move() instead of applying forces to it.
+         */
+        bool is_static() const;
+
+        /**
+         * Make the body static or not. See is_static(). A static body is not kinematic.
+         */
+        void set_static(bool s);
+
+        /**
+         * Return whether the body is kinematic. Kinematic bodies move according to the velocity & angular velocity
+         * set by the user, but they won't be affected by any forces or collisions, like static bodies.
+         * Use them for moving platforms.
+         */
+        bool is_kinematic() const;
+
+        /**
+         * Make the body kinematic or not. See is_kinematic(). A kinematic body is not static.
+         */
+        void set_kinematic(bool k);
+
+        /**
+         * Return whether the body is dynamic, i.e. neither static nor kinematic. Only dynamic bodies are affected
+         * by forces & collisions.
+         */
+        bool is_dynamic() const;
+
+
+        /**
+         * Return the axis-aligned bounding box of the body, i.e. the smallest box containing each of its shapes.
+         * Throws GeometryException if the body has no shape.
+         */
+        AABB get_aabb() const;
 
 
         /**
          * Add a shape to the body. Return a reference to the body so you can chain those method calls.
+         * Throws GeometryException if the shape already belongs to a body.
          */
         Body& add_shape(const std::shared_ptr<Shape>& shape);
 
@@ -82,7 +170,7 @@ namespace Msfl2D {
          * For 1-shape bodies, this is equivalent to rotate(angle).
          * @param idx the index of the shape to update. Throws GeometryException is the index does not exists.
          */
-        void rotate_shape(int idx, double angle);
+        void rotate_shape(int idx, real angle);
 
         /**
          * Move the position of the body. Will move each shapes the same way.
@@ -94,13 +182,13 @@ namespace Msfl2D {
          * Rotate the body around its center.
          * @param angle in radians
          */
-        void rotate(double angle);
+        void rotate(real angle);
 
         /**
          * Rotate the body around a specified point (in global coordinates).
          * Its position will also be modified.
          */
-        void rotate(double angle, const Vec2D& center);
+        void rotate(real angle, const Vec2D& center);
 
 
         /**
@@ -118,39 +206,99 @@ namespace Msfl2D {
         /**
          * Register a force to be applied to the body. The given position must be relative to the body center.
          * You can obtain this position simply by doing absolute_force_position - body.position
+         * The force is immediately reduced to a linear force and a torque around the body center.
          */
         void register_force(Vec2D force, Vec2D application_point);
 
         /**
-         * Apply the forces previously registered (using register_force) to the body.
+         * Apply the forces previously registered (using register_force) to the body, modifying its velocity
+         * & angular velocity. The body is not moved; see integrate().
          * @param delta_t time to simulate, in seconds.
+         * @param acceleration acceleration applied to the whole body on top of the registered forces, no matter
+         *        its mass (for example, the gravity of the world). Static & kinematic bodies ignore it.
          */
-        void apply_forces(double delta_t);
+        void apply_forces(real delta_t, const Vec2D& acceleration = Vec2D::ZERO);
+
+        /**
+         * Instantly change the velocity & angular velocity of the body by applying an impulse to it.
+         * The given position must be relative to the body center. Static & kinematic bodies are not affected.
+         */
+        void apply_impulse(const Vec2D& impulse, const Vec2D& application_point);
+
+        /**
+         * Move & rotate the body according to its velocity & angular velocity.
+         * @param delta_t time to simulate, in seconds.
+         */
+        void integrate(real delta_t);
 
 
         /**
          * Return the bounciness of the body.
          */
-        double get_bounciness() const;
+        real get_bounciness() const;
 
         /**
          * Set the bounciness of the body.
          * Throw SimulationException if the value is not between 0 & 1.
          */
-        void set_bounciness(double b);
+        void set_bounciness(real b);
+
+        /**
+         * Set mass of the body. The mass is distributed over the shapes of the body according to their area.
+         * Throw SimulationException if the mass is not > 0.
+         */
+        void set_mass(real m);
+
+        /**
+         * Return the mass of the body, or 0 if the body is static or kinematic.
+         */
+        real get_mass() const;
+
+        /**
+         * Return the inverse of the mass of the body. Static & kinematic bodies have an inverse mass of 0.
+         */
+        real get_inv_mass() const;
+
+        /**
+         * Return the moment of inertia of the body around its center, or 0 if the body is static or kinematic.
+         */
+        real get_inertia() const;
 
         /**
-         * Set mass of the body.
-         * Doesn't do anything if the body is static.
+         * Return the inverse of the moment of inertia of the body. Static & kinematic bodies have an inverse inertia of 0.
          */
-        void set_mass(double m);
+        real get_inv_inertia() const;
+
+        void set_friction(real f);
 
+        real get_friction() const;
+
+        /**
+         * Return the collision categories of the body, a bit field (1 by default). The bodies collide only if the
+         * categories of each one are in the mask of the other (see can_collide()).
+         */
+        std::uint32_t get_collision_category() const;
+
+        /**
+         * Set the collision categories of the body. They are also used to filter the spatial queries of the World.
+         */
+        void set_collision_category(std::uint32_t category);
 
-        double get_mass() const;
+        /**
+         * Return the collision mask of the body, i.e. the categories of the bodies it collides with (all of them by
+         * default).
+         */
+        std::uint32_t get_collision_mask() const;
 
-        void set_friction(double f);
+        /**
+         * Set the collision mask of the body.
+         */
+        void set_collision_mask(std::uint32_t mask);
 
-        double get_friction() const;
+        /**
+         * Return whether the collision filters of both bodies let them collide.
+         */
+        bool can_collide(const Body& other) const;
 
 
         /**
@@ -176,6 +324,17 @@ namespace Msfl2D {
     protected:
         friend class World;
         friend class CollisionDetector;
+        friend class CollisionResolver;
+        friend class BodyStorage;
+        friend class Joint;
+        friend struct ContactConstraint;
+
+        /**
+         * Storage containing the values of the body, and index of its row. The row may move when other bodies are
+         * removed from the storage, in which case the index is updated by the storage.
+         */
+        BodyStorage* storage;
+        int index;
 
         /**
          * Count the number of points of this body colliding at a given moment.
@@ -183,41 +342,97 @@ namespace Msfl2D {
          */
         int nb_colliding_points = 0;
 
+        /**
+         * ID given to the body by the World it was added to.
+         */
+        BodyID id = 0;
+
+        /**
+         * Joints attached to this body. This list is managed by the World when adding or removing joints.
+         */
+        std::vector<Joint*> joints;
+
+        /**
+         * Create a body with no shape, directly in a row of the given storage (the storage of a World).
+         */
+        explicit Body(BodyStorage& world_storage);
+
+        /**
+         * Return whether this body is attached to the other one by a joint.
+         */
+        bool is_connected(const Body& other) const;
+
+        /**
+         * Move the values of the body to a new row of the given storage (the storage of a World).
+         */
+        void attach(BodyStorage& new_storage);
+
+        /**
+         * Move the values of the body from the storage it is attached to, to a storage of its own.
+         */
+        void detach();
+
+        /**
+         * Remove the row of the body from the storage it is attached to, without keeping its values.
+         * Used by the World when it holds the last reference to the body, which is about to be destroyed.
+         */
+        void release();
+
+        /**
+         * Detach the shapes of the body which are referenced elsewhere from its storage, and release the others.
+         * Used when the body is about to be destroyed.
+         */
+        void release_shapes();
+
+        /**
+         * Move the shapes of the body by the displacement, then rotate them around the body center.
+         * Used when the position & rotation of the body were changed directly in its storage.
+         */
+        void transform_shapes(const Vec2D& displacement, const Rotor2D& rotation);
+
 
     private:
-        // Position, or "center" of the body. It must be the average position of each shape position.
-        // This value will update each time you add/remove a shape from the body.
+        // Storage of the body while it is not in a World
+        std::unique_ptr<BodyStorage> own_storage;
+
+        // The position, or "center" of the body, is stored in its row. It must be the average position of each
+        // shape position. This value will update each time you add/remove a shape from the body.
         // Most of the time, your body will only have one shape, so its position is "obvious" (the center of the shape).
         // It may become less obvious when constructing bodies with multiple shapes.
-        Vec2D position = {0, 0};
 
         // Like for vertices in ComplexPolygons, the center of a body is the average position of its shapes.
         // The constructors of the Body takes care of updating body center.
         std::vector<std::shared_ptr<Shape>> shapes;
 
 
-        // Collision resolution (among other things, like gravity application) will add a force to this vector along
-        // with the application point of the force (relative to the body center).
-        std::vector<std::tuple<Vec2D, Vec2D>> forces;
-
         /**
          * A value between 0 & 1 representing how bouncy the body is. 0 = not bouncy at all, 1 = as bouncy as possible.
          */
-        double bounciness = 0.7;
+        real bounciness = 0.7;
 
         /**
          * A value between 0 & 1 representing the amount of resistance the body applies to friction forces.
          */
-        double friction = 0.3;
+        real friction = 0.3;
+
+        real mass = 1;
+
+        // Collision filter, see get_collision_category() & get_collision_mask()
+        std::uint32_t collision_category = 1;
+        std::uint32_t collision_mask = ALL_CATEGORIES;
 
-        // Might prefer to use the inverse of the mass to speed up the computing
-        double mass = 1;
+        // Moment of inertia cached by update_mass_properties(), so the simulation doesn't have to compute it
+        // again at each step. Its inverse & the inverse of the mass are stored in the row of the body, and are 0
+        // for static & kinematic bodies.
+        real inertia = 0;
 
 
         /**
-         * Update the center of the body so it is at the average position of each shape.
+         * Update the center of the body so it is at the center of mass of its shapes, and recompute
+         * its moment of inertia along with the inverse of its mass & inertia.
+         * Must be called each time the shapes, the mass or the type (static, kinematic) of the body change.
          */
-        void update_center();
+        void update_mass_properties();
     };
 
 } // Mslf2D
@@ -0,0 +1,90 @@
+//
+// Created by myselfleo on 20/07/2023.
+//
+
+#include "BodyStorage.hpp"
+#include "Body.hpp"
+
+namespace Msfl2D {
+    BodyStorage::BodyStorage(
+            const std::shared_ptr<MemoryCounter>& row_counter,
+            const std::shared_ptr<MemoryCounter>& vertex_counter
+            ):
+        positions(CountingAllocator<Vec2D>(row_counter)),
+        rotations(CountingAllocator<Rotor2D>(row_counter)),
+        velocities(CountingAllocator<Vec2D>(row_counter)),
+        angular_velocities(CountingAllocator<real>(row_counter)),
+        forces(CountingAllocator<Vec2D>(row_counter)),
+        torques(CountingAllocator<real>(row_counter)),
+        inv_masses(CountingAllocator<real>(row_counter)),
+        inv_inertias(CountingAllocator<real>(row_counter)),
+        types(CountingAllocator<BodyType>(row_counter)),
+        handles(CountingAllocator<Body*>(row_counter)),
+        vertices(vertex_counter)
+        {}
+
+    int BodyStorage::size() const {
+        return handles.size();
+    }
+
+    int BodyStorage::add(Body *handle) {
+        version++;
+        positions.emplace_back(0, 0);
+        rotations.emplace_back();
+        velocities.emplace_back(0, 0);
+        angular_velocities.push_back(0);
+        forces.emplace_back(0, 0);
+        torques.push_back(0);
+        inv_masses.push_back(1);
+        inv_inertias.push_back(0);
+        types.push_back(BodyType::DYNAMIC);
+        handles.push_back(handle);
+        return handles.size() - 1;
+    }
+
+    void BodyStorage::reserve(int nb_rows) {
+        positions.reserve(nb_rows);
+        rotations.reserve(nb_rows);
+        velocities.reserve(nb_rows);
+        angular_velocities.reserve(nb_rows);
+        forces.reserve(nb_rows);
+        torques.reserve(nb_rows);
+        inv_masses.reserve(nb_rows);
+        inv_inertias.reserve(nb_rows);
+        types.reserve(nb_rows);
+        handles.reserve(nb_rows);
+    }
+
+    void BodyStorage::remove(int index) {
+        version++;
+        int last = size() - 1;
+        if (index != last) {
+            copy_row(*this, last, *this, index);
+            handles[index] = handles[last];
+            handles[index]->index = index;
+        }
+
+        positions.pop_back();
+        rotations.pop_back();
+        velocities.pop_back();
+        angular_velocities.pop_back();
+        forces.pop_back();
+        torques.pop_back();
+        inv_masses.pop_back();
+        inv_inertias.pop_back();
+        types.pop_back();
+        handles.pop_back();
+    }
+
+    void BodyStorage::copy_row(const BodyStorage &from, int from_index, BodyStorage &to, int to_index) {
+        to.positions[to_index] = from.positions[from_index];
+        to.rotations[to_index] = from.rotations[from_index];
+        to.velocities[to_index] = from.velocities[from_index];
+        to.angular_velocities[to_index] = from.angular_velocities[from_index];
+        to.forces[to_index] = from.forces[from_index];
+        to.torques[to_index] = from.torques[from_index];
+        to.inv_masses[to_index] = from.inv_masses[from_index];
+        to.inv_inertias[to_index] = from.inv_inertias[from_index];
+        to.types[to_index] = from.types[from_index];
+    }
+} // Msfl2D
@@ -0,0 +1,107 @@
+//
+// Created by myselfleo on 20/07/2023.
+//
+
+#ifndef MSFL2D_BODYSTORAGE_HPP
+#define MSFL2D_BODYSTORAGE_HPP
+
+#include "Vec2D.hpp"
+#include "Transform2D.hpp"
+#include "VertexStorage.hpp"
+#include "MemoryStats.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace Msfl2D {
+
+    class Body;
+
+    /**
+     * Type of a body, determining how the simulation affects it.
+     */
+    enum class BodyType: unsigned char {
+        /** Affected by forces & collisions */
+        DYNAMIC,
+        /** Never moves, unless moved by the user */
+        STATIC,
+        /** Moves according to the velocity set by the user, but is not affected by forces & collisions */
+        KINEMATIC
+    };
+
+
+    /**
+     * Storage of the values of the bodies used at each simulation step (position, velocity, etc.), as one
+     * contiguous array per value (structure of arrays). The integration & the solver go through those arrays
+     * instead of visiting each Body, which is only a handle to a row of the storage.
+     *
+     * The rows are kept contiguous: removing a row moves the last one in its place, and the handle of the moved row
+     * is updated accordingly.
+     */
+    class BodyStorage {
+    public:
+        CountedVector<Vec2D> positions;
+        CountedVector<Rotor2D> rotations;
+        CountedVector<Vec2D> velocities;
+        CountedVector<real> angular_velocities;
+
+        // Sum of the forces registered since the last reset, and of the torques they produce around the body center
+        CountedVector<Vec2D> forces;
+        CountedVector<real> torques;
+
+        // Inverses of the mass & moment of inertia. They are 0 for static & kinematic bodies.
+        CountedVector<real> inv_masses;
+        CountedVector<real> inv_inertias;
+
+        CountedVector<BodyType> types;
+
+        // Handle of each row
+        CountedVector<Body*> handles;
+
+        // Vertices of the polygons of the bodies
+        VertexStorage vertices;
+
+        // Incremented each time a row is added or removed, or the shapes of a body are changed or moved by the user.
+        // The World increments it after each step, as the steps move the bodies too. The spatial queries rebuild their
+        // tree when it changes.
+        std::uint64_t version = 0;
+
+
+        /**
+         * Create an empty storage. The memory of the rows & of the vertices is counted in the given counters if they
+         * are not null.
+         */
+        explicit BodyStorage(
+                const std::shared_ptr<MemoryCounter>& row_counter = nullptr,
+                const std::shared_ptr<MemoryCounter>& vertex_counter = nullptr
+                );
+
+        /**
+         * Return the number of rows of the storage.
+         */
+        int size() const;
+
+        /**
+         * Add a row for the given body, filled with default values (dynamic body at rest at {0, 0}), and return its index.
+         */
+        int add(Body* handle);
+
+        /**
+         * Reserve memory for the given number of rows, so that adding rows up to that number doesn't allocate.
+         */
+        void reserve(int nb_rows);
+
+        /**
+         * Remove the row at the given index. The last row takes its place, and the index of its handle is updated.
+         */
+        void remove(int index);
+
+        /**
+         * Copy a row of a storage to a row of another storage. The handle is not copied.
+         */
+        static void copy_row(const BodyStorage& from, int from_index, BodyStorage& to, int to_index);
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_BODYSTORAGE_HPP
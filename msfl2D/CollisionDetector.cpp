@@ -12,51 +12,66 @@
 namespace Msfl2D {
 
     SATResult SATResult::no_collision() {
-        return {false, Msfl2D::Vec2D(), 0, 0, nullptr, nullptr, nullptr, nullptr, nullptr}; // pen_vec and depth values are not important
+        return {false, Msfl2D::Vec2D(), 0, 0, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr}; // pen_vec and depth values are not important
+    }
+
+    bool SATResult::is_speculative() const {
+        return depth < 0;
     }
 
     SATResult::SATResult(
             bool collide,
             Vec2D pen_vec,
-            double depth,
+            real depth,
             int nb_col_points,
             Vec2D col_points[2],
-            std::shared_ptr<ConvexPolygon> ref,
-            std::shared_ptr<ConvexPolygon> inc,
-            std::shared_ptr<Body> refb,
-            std::shared_ptr<Body> incb
+            real point_depths[2],
+            const ConvexPolygon* ref,
+            const ConvexPolygon* inc,
+            Body* refb,
+            Body* incb
             ):
         collide(collide),
         minimum_penetration_vector(pen_vec),
         depth(depth),
         nb_collision_points(nb_col_points),
-        reference_shape(std::move(ref)),
-        incident_shape(std::move(inc)),
-        ref_body(std::move(refb)),
-        inc_body(std::move(incb))
+        reference_shape(ref),
+        incident_shape(inc),
+        ref_body(refb),
+        inc_body(incb)
         {
         if (col_points != nullptr) {
             for (int i=0; i<2; i++) {
                 collision_points[i] = col_points[i];
             }
         }
+        if (point_depths != nullptr) {
+            for (int i=0; i<2; i++) {
+                depths[i] = point_depths[i];
+            }
+        }
     }
 
 
-    SATResult CollisionDetector::sat(std::shared_ptr<ConvexPolygon> shape1, std::shared_ptr<ConvexPolygon> shape2) {
+    SATResult CollisionDetector::sat(
+            const ConvexPolygon* shape1,
+            const ConvexPolygon* shape2,
+            real speculative_distance
+            ) {
         // 1. We find the reference side. This is the side of a ConvexPolygon for which the penetration value is the least.
         //    This is the vector of minimal penetration.
         //    We also conserve the penetration depth for that penetration vector; it will be used later to find the collision potential_collision_points.
-        //    Finally, this step also allow to find if there is no collision: if we find a axis for which the penetration is 0, then
-        //    this axis is a separating axis and the shapes do not collide. (we return early from that)
+        //    Finally, this step also allow to find if there is no collision: if we find a axis for which the penetration is negative, then
+        //    this axis is a separating axis and the shapes do not collide. We still keep going if they are closer than
+        //    speculative_distance, in which case the separating axis becomes the reference side (with a negative depth).
 
         Vec2D minimum_penetration_vector {0, 0};         // initialisation value, will be changed
-        double depth = -1;                                      // initialisation value, will be changed
+        real depth = 0;                                       // initialisation value, will be changed
         LineSegment reference_side;
-        double min_dist_from_ref_side;
+        real min_dist_from_ref_side;
         Vec2D min_dist_point;
-        std::shared_ptr<ConvexPolygon> reference_polygon;       // Polygon owning the reference side
-        std::shared_ptr<ConvexPolygon> incident_polygon;        // Polygon "entering" the reference polygon
+        const ConvexPolygon* reference_polygon = nullptr;      // Polygon owning the reference side
+        const ConvexPolygon* incident_polygon = nullptr;       // Polygon "entering" the reference polygon
 
 
 
@@ -84,11 +99,12 @@ namespace Msfl2D {
             LineSegment proj_shape_1 = shape1->project(proj_line);
             LineSegment proj_shape_2 = shape2->project(proj_line);
 
-            LineSegment penetration;
-            penetration = LineSegment::intersection(proj_shape_1, proj_shape_2);
+            // Signed overlap of the projections. A negative value means we found a separating axis, and that
+            // the shapes are at least that far from each other.
+            real penetration = Segment::overlap(proj_shape_1.segment, proj_shape_2.segment);
 
-            // No intersection => we found a separating axis
-            if (penetration.length() == 0) {
+            // The shapes are too far from each other to collide, even during the next step.
+            if (penetration < -speculative_distance) {
                 return SATResult::no_collision();
             }
 
@@ -97,9 +113,9 @@ namespace Msfl2D {
             // We need to compute the minimal distance between the vertices of the potential incident polygon
             // & the potential reference side. This is to prevent a parallel side to the desired side to be considered
             // reference side.
-            double min_dist = -1;
+            real min_dist = -1;
             for (int j=0; j<shape2->nb_vertices(); j++) {
-                double dist = shape2->get_global_vertex(j).distance_squared(tested_side.line);
+                real dist = shape2->get_global_vertex(j).distance_squared(tested_side.line);
                 if (dist < min_dist || min_dist == -1) {
                     min_dist = dist;
                 }
@@ -107,8 +123,8 @@ namespace Msfl2D {
 
 
             // Potential reference side
-            double current_penetration = std::round(penetration.length() * 1e6) / 1e6; // keep 6 digits precision
-            if (depth == -1 || current_penetration < depth) {
+            real current_penetration = std::round(penetration * PENETRATION_PRECISION) / PENETRATION_PRECISION;
+            if (reference_polygon == nullptr || current_penetration < depth) {
                 depth = current_penetration;
                 minimum_penetration_vector = proj_axis;
                 reference_side = tested_side;
@@ -146,18 +162,63 @@ namespace Msfl2D {
         //    I.e we find the intersections between each side of the incident polygon and the 2 lines normal to the
         //    reference side crossing with the reference side extremities. This will give us a list of points, to which
         //    we also include the vertices of the incident side.
-        //    We'll filter them in the next step.
+        //    Each of those potential collision points is filtered as soon as it is found (see step 3), so they
+        //    don't need to be stored.
+        //
+        // 3. We only keep the potential collision points:
+        //    - That "crossed" the reference side (i.e the ones on the RIGHT or directly on the side
+        //      (and which projection is on the reference side). For speculative contacts, no point crossed yet, so
+        //      we also accept the ones closer to the side than speculative_distance.
+        //    - The 2 farest from that side (they are the ones that crossed it first). Keeping 2 points, even if one
+        //      is not as deep as the other, keeps resting bodies from rocking on one corner then the other.
+
+        int nb_points = 0;
+        Vec2D col_points[2];
+        real point_depths[2] = {0, 0};
+
+        // ConvexPolygons are represented clockwise, meaning that the normal of the reference side points inside the
+        // reference polygon, and that a point to the right of one of its side "crossed it", if coming from the exterior.
+        std::tuple<Vec2D, Vec2D> end_points = reference_side.coordinates();
+        Vec2D side_origin = std::get<0>(end_points);
+        Vec2D inward_normal = minimum_penetration_vector.normalized();
+
+        auto add_potential_point = [&](const Vec2D& p) {
+            // Signed distance between the point and the reference side, positive if the point crossed the side.
+            real penetration = Vec2D::dot(p - side_origin, inward_normal);
+            if (penetration < -speculative_distance) {return;}
+
+            real projection = p.project(reference_side.line);
+            // The points produced by the clipping lie on the side planes, give or take rounding errors
+            if (projection < reference_side.segment.min - POINT_TOLERANCE
+                || projection > reference_side.segment.max + POINT_TOLERANCE) {return;}
+
+            // The clipping may produce the same point twice
+            for (int j=0; j<nb_points; j++) {
+                if (Vec2D::distance_squared(p, col_points[j]) < POINT_TOLERANCE * POINT_TOLERANCE) {return;}
+            }
 
+            // only keep the 2 farest potential_collision_points from the reference side, the farest first
+            if (nb_points < 2) {
+                col_points[nb_points] = p;
+                point_depths[nb_points] = penetration;
+                nb_points++;
+            }
+            else if (penetration > point_depths[1]) {
+                col_points[1] = p;
+                point_depths[1] = penetration;
+            }
+
+            if (nb_points == 2 && point_depths[1] > point_depths[0]) {
+                std::swap(col_points[0], col_points[1]);
+                std::swap(point_depths[0], point_depths[1]);
+            }
+        };
 
-        std::vector<Vec2D> potential_collision_points;
-        std::vector<LineSegment> debug_sides;
         for (i=0; i<incident_polygon->nb_vertices(); i++) {
-            potential_collision_points.push_back(incident_polygon->get_global_vertex(i));
+            add_potential_point(incident_polygon->get_global_vertex(i));
         }
 
-
         // The 2 normal lines coming from the end potential_collision_points of the reference side.
-        std::tuple<Vec2D, Vec2D> end_points = reference_side.coordinates();
         Line l1 = Line::from_director_vector(std::get<0>(end_points), minimum_penetration_vector);
         Line l2 = Line::from_director_vector(std::get<1>(end_points), minimum_penetration_vector);
 
@@ -170,58 +231,14 @@ namespace Msfl2D {
                     );
 
             // Check for intersection with one of the normal lines
-            try {
-                potential_collision_points.push_back(tested_side.intersection(l1));
-                debug_sides.push_back(tested_side);
-            }
-            catch (GeometryException& e) {}
-            try {
-                potential_collision_points.push_back(tested_side.intersection(l2));
-                debug_sides.push_back(tested_side);
-            }
-            catch (GeometryException& e) {}
+            Vec2D intersection;
+            if (tested_side.intersection(l1, intersection)) {add_potential_point(intersection);}
+            if (tested_side.intersection(l2, intersection)) {add_potential_point(intersection);}
         }
 
 
-        // 3. Now, we have a list of potential collision potential_collision_points. We'll only keep:
-        //    - The ones that "crossed" the reference side (i.e the ones on the RIGHT or directly on the side
-        //      (and which projection is on the reference side)
-        //    - The ones the farest from that side (they are the ones that crossed it first)
-
-        int nb_points = 0;
-        double max_distance = 0;
-        Vec2D col_points[2];
-
-
-        for (auto& p: potential_collision_points) {
-            // Only consider potential_collision_points that crossed the reference side.
-            // ConvexPolygons are represented clockwise, meaning that a point to the right of one of its
-            // side "crossed it", if coming from the exterior.
-            if (reference_side.line.side(p) == LineSide::LEFT) {continue;}
-
-            double projection = p.project(reference_side.line);
-            if (projection < reference_side.segment.min || projection > reference_side.segment.max) {continue;}
-
-            double current_distance = std::round(p.distance_squared(reference_side.line) * 1e6) / 1e6;
-
-            // only keep the farest potential_collision_points from the reference side
-            if (nb_points == 0 || current_distance > max_distance) {
-                col_points[0] = p;
-                max_distance = current_distance;
-                nb_points = 1;
-            }
-            else if (current_distance == max_distance && nb_points == 1) {
-                col_points[1] = p;
-                nb_points = 2;
-            }
-        }
-
-
-        // Increase collision point counter to the shapes
-        std::shared_ptr<Body> ref_body = reference_polygon->get_body();
-        std::shared_ptr<Body> inc_body =  incident_polygon->get_body();
-
-        inc_body->nb_colliding_points += nb_points;
+        Body* ref_body = reference_polygon->get_body();
+        Body* inc_body = incident_polygon->get_body();
 
 
 
@@ -233,6 +250,7 @@ namespace Msfl2D {
                 depth,
                 nb_points,
                 col_points,
+                point_depths,
                 reference_polygon,
                 incident_polygon,
                 ref_body,
@@ -6,6 +6,7 @@
 #define MSFL2D_COLLISIONDETECTOR_HPP
 
 #include <memory>
+#include <type_traits>
 #include "ConvexPolygon.hpp"
 
 namespace Msfl2D {
@@ -16,9 +17,13 @@ namespace Msfl2D {
      * @param minimum_penetration_vector The vector (from shape1 to shape2) for which the penetration is minimal, normalized
      * @param depth the penetration distance between the 2 shapes, along the minimum_penetration_vector.
      *              this is the distance to move one of the shape from the other (along the minimum_penetration_vector)
-     *              so that they barely touch.
+     *              so that they barely touch. A negative depth means that the shapes are not touching yet but are
+     *              close enough to collide during the next step (speculative contact); -depth is then the distance
+     *              separating them.
      * @param nb_collision_points the number of collision points. There may be 1 or 2.
      * @param collision_point The collision points. They are the points that collided first, hence the limit of 2.
+     * @param depths The penetration depth of each collision point, the deepest first. Like the depth of the
+     *               collision, it is negative for points not touching the other shape yet.
      * @param reference_shape Pointer to the reference shape
      * @param incident_shape Pointer to the other shape
      * @param ref_body Pointer to the reference body (owner of the reference shape)
@@ -27,39 +32,60 @@ namespace Msfl2D {
     struct SATResult {
         bool collide;
         Vec2D minimum_penetration_vector;
-        double depth;
+        real depth;
         int nb_collision_points;
         Vec2D collision_points[2];
-        std::shared_ptr<ConvexPolygon> reference_shape;
-        std::shared_ptr<ConvexPolygon> incident_shape;
-        std::shared_ptr<Body> ref_body;
-        std::shared_ptr<Body> inc_body;
+        real depths[2] = {0, 0};
+        const ConvexPolygon* reference_shape;
+        const ConvexPolygon* incident_shape;
+        Body* ref_body;
+        Body* inc_body;
 
 
         SATResult(
                 bool collide,
                 Vec2D pen_vec,
-                double depth,
+                real depth,
                 int nb_col_points,
                 Vec2D col_points[2],
-                std::shared_ptr<ConvexPolygon> ref_shape,
-                std::shared_ptr<ConvexPolygon> inc_shape,
-                std::shared_ptr<Body> ref_body,
-                std::shared_ptr<Body> inc_body
+                real point_depths[2],
+                const ConvexPolygon* ref_shape,
+                const ConvexPolygon* inc_shape,
+                Body* ref_body,
+                Body* inc_body
                 );
 
         /** Return a "no collision" SATResult */
         static SATResult no_collision();
 
+        /** Return whether this is a speculative contact, i.e. the shapes are close but not touching yet. */
+        bool is_speculative() const;
+
     };
 
     /** This static class contains numerous methods used to detect collision between shapes. */
     class CollisionDetector {
     public:
+        /** Distance under which 2 collision points are considered the same, or a point is considered on a side */
+        static constexpr real POINT_TOLERANCE = 1e-6;
+
+        /**
+         * The penetrations along the tested axes are rounded to 1 / PENETRATION_PRECISION, so that sides giving the
+         * same penetration are found equal despite rounding errors. Floats need a coarser rounding.
+         */
+        static constexpr real PENETRATION_PRECISION = std::is_same<real, float>::value ? 1e4 : 1e6;
+
         /**
          * Perform a SAT test to compute collision information about two shapes.
+         * It only reads the shapes, so several tests can run at the same time on different threads.
+         * @param speculative_distance shapes separated by less than this distance are reported as colliding, with a
+         *        negative depth. This allows the resolver to stop fast bodies before they go through each other.
          */
-        static SATResult sat(std::shared_ptr<ConvexPolygon> shape1, std::shared_ptr<ConvexPolygon> shape2);
+        static SATResult sat(
+                const ConvexPolygon* shape1,
+                const ConvexPolygon* shape2,
+                real speculative_distance = 0
+                );
     };
 
 } // Msfl2D
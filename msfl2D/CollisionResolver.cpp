@@ -3,205 +3,198 @@
 //
 
 #include "CollisionResolver.hpp"
-#include "MsflExceptions.hpp"
-
-namespace Msfl2D {
-    void CollisionResolver::resolve(const SATResult &col_result, double delta_t) {
-        // Return early if CollisionDetector lies (its not our problem)
-        if (col_result.nb_collision_points == 0) {return;}
-
-        // Return early as no body can move
-        if (col_result.ref_body->is_static && col_result.inc_body->is_static) {return;}
-
-        collision(col_result, delta_t);
-
-        friction(col_result, delta_t);
-
-        // Move the shapes so they are not intersecting.
-        separate(col_result);
-    }
-
-
 
+#include <algorithm>
 
-
-    void CollisionResolver::point_collision(const SATResult &col_result, double delta_t, int point_idx) {
-        if (point_idx >= col_result.nb_collision_points) {
-            throw InternalException("point_collision: Given a point index higher than the collision point count");
+namespace Msfl2D {
+    ContactConstraint::ContactConstraint(const SATResult &result, BodyID id1, BodyID id2):
+        result(result),
+        body1_id(std::min(id1, id2)),
+        body2_id(std::max(id1, id2)),
+        body1_is_ref(result.ref_body->id == body1_id),
+        ref_index(result.ref_body->index),
+        inc_index(result.inc_body->index),
+        friction((result.ref_body->get_friction() + result.inc_body->get_friction()) / 2),
+        bounciness((result.ref_body->get_bounciness() + result.inc_body->get_bounciness()) / 2)
+        {
+        const Vec2D& n = result.minimum_penetration_vector;
+        tangent = Vec2D(n.y, -n.x);
+
+        // The normal points towards the reference body: the bodies approach each other when the reference body
+        // moves against it, relatively to the incident body
+        const Body& ref = *result.ref_body;
+        const Body& inc = *result.inc_body;
+        for (int i=0; i<result.nb_collision_points; i++) {
+            const Vec2D& p = result.collision_points[i];
+            Vec2D ref_velocity = ref.get_velocity() + Vec2D::cross(ref.get_angular_velocity(), p - ref.get_center());
+            Vec2D inc_velocity = inc.get_velocity() + Vec2D::cross(inc.get_angular_velocity(), p - inc.get_center());
+            real speed = -Vec2D::dot(ref_velocity - inc_velocity, n);
+            approach_speed = i == 0 ? speed : std::max(approach_speed, speed);
         }
+    }
 
-        std::shared_ptr<Body> ref_body = col_result.ref_body;
-        std::shared_ptr<Body> inc_body = col_result.inc_body;
-
-        Vec2D point = col_result.collision_points[point_idx];
-
-        // Mass of the reference body is distributed over each point of the current collision
-        double reference_mass = ref_body->get_mass() / col_result.nb_collision_points;
-        // Mass of the incident body is distributed over each point on which it lies during this update step.
-        double incident_mass = inc_body->get_mass() / inc_body->get_nb_collisions();
-        double mass_sum = reference_mass + incident_mass;
-
-        Vec2D min_pen_vec = col_result.minimum_penetration_vector;
-
-        // We use the body's velocity, not the points one.
-        // The angular velocity of the collision point will be used later in the collision resolution process.
-        Vec2D ref_velocity = ref_body->velocity;
-        Vec2D inc_velocity = inc_body->velocity;
-
-        // We keep only the component of each velocity that goes in the direction of the collision
-        // Compute the component of each body velocity in the direction of the collision
-        Vec2D ref_coll_velocity = min_pen_vec * Vec2D::dot(min_pen_vec, ref_velocity);
-        Vec2D inc_coll_velocity = min_pen_vec * Vec2D::dot(min_pen_vec, inc_velocity);
-
-
-
-        /*// Return early if the two points are receding in the axis of penetration
-        double current_dist = Vec2D::distance_squared(ref_body->get_center(), inc_body->get_center());
-        double next_dist = Vec2D::distance_squared(
-                ref_body->get_center() + ref_coll_velocity * APPROACHING_PRECISION,
-                inc_body->get_center() + inc_coll_velocity * APPROACHING_PRECISION);
-        if (current_dist < next_dist) {return;}*/
-
-
-
-        // Compute linear momentum of the collision
-        Vec2D ref_lin_momentum = ref_coll_velocity * reference_mass;
-        Vec2D inc_lin_momentum = inc_coll_velocity * incident_mass;
-        Vec2D total_lin_momentum = ref_lin_momentum + inc_lin_momentum;
-
-        // Compute angular momentum of the collision
-        Vec2D ref_ang_momentum = ref_body->get_point_angular_momentum(point - ref_body->get_center());
-        Vec2D inc_ang_momentum = inc_body->get_point_angular_momentum(point - inc_body->get_center());
-        Vec2D total_ang_momentum = ref_ang_momentum + inc_ang_momentum;
-
-
-
-        // Find the final velocity of the points, after the collision, in order
-        // to compute the forces to be applied
-        Vec2D velocity_diff = ref_coll_velocity - inc_coll_velocity;
-
-
-
-        Vec2D ref_final_velocity;
-        Vec2D inc_final_velocity;
 
-        Vec2D ref_final_lin_momentum;
-        Vec2D inc_final_lin_momentum;
 
-        if (col_result.ref_body->is_static) {
-            ref_final_velocity = {0, 0};
-            inc_final_velocity = -total_lin_momentum / mass_sum;
-        }
-        else if (col_result.inc_body->is_static) {
-            inc_final_velocity = {0, 0};
-            ref_final_velocity = -total_lin_momentum / mass_sum;
-        }
-        else {
-            ref_final_velocity = (total_lin_momentum - velocity_diff * incident_mass) / mass_sum;
-            inc_final_velocity = (total_lin_momentum + velocity_diff * reference_mass) / mass_sum;
+    void CollisionResolver::prepare(const BodyStorage &bodies, ContactConstraint &contact, real delta_t) {
+        const SATResult& r = contact.result;
+        const Vec2D& n = r.minimum_penetration_vector;
+        int ref = contact.ref_index;
+        int inc = contact.inc_index;
+
+        real ref_inv_mass = bodies.inv_masses[ref];
+        real inc_inv_mass = bodies.inv_masses[inc];
+        real ref_inv_inertia = bodies.inv_inertias[ref];
+        real inc_inv_inertia = bodies.inv_inertias[inc];
+
+        for (int i=0; i<r.nb_collision_points; i++) {
+            Vec2D ref_arm = r.collision_points[i] - bodies.positions[ref];
+            Vec2D inc_arm = r.collision_points[i] - bodies.positions[inc];
+            contact.ref_arms[i] = ref_arm;
+            contact.inc_arms[i] = inc_arm;
+
+            real ref_n = Vec2D::cross(ref_arm, n);
+            real inc_n = Vec2D::cross(inc_arm, n);
+            real normal_inv_mass = ref_inv_mass + inc_inv_mass
+                    + ref_inv_inertia * ref_n * ref_n + inc_inv_inertia * inc_n * inc_n;
+            contact.normal_masses[i] = normal_inv_mass > 0 ? 1 / normal_inv_mass : 0;
+
+            real ref_t = Vec2D::cross(ref_arm, contact.tangent);
+            real inc_t = Vec2D::cross(inc_arm, contact.tangent);
+            real tangent_inv_mass = ref_inv_mass + inc_inv_mass
+                    + ref_inv_inertia * ref_t * ref_t + inc_inv_inertia * inc_t * inc_t;
+            contact.tangent_masses[i] = tangent_inv_mass > 0 ? 1 / tangent_inv_mass : 0;
+
+            if (r.depths[i] < 0) {
+                // The point is not touching the other shape yet: the bodies may keep approaching each other,
+                // as long as it barely touches at the end of the step.
+                contact.target_velocities[i] = r.depths[i] / delta_t;
+            }
+            else {
+                // The bodies bounce back, unless they are almost resting on each other
+                real normal_velocity = Vec2D::dot(relative_velocity(bodies, contact, i), n);
+                contact.target_velocities[i] = normal_velocity < -RESTITUTION_THRESHOLD
+                        ? -contact.bounciness * normal_velocity
+                        : 0;
+            }
         }
-
-        Vec2D ref_velocity_change = ref_final_velocity - ref_coll_velocity;
-        Vec2D inc_velocity_change = inc_final_velocity - inc_coll_velocity;
-
-
-        double bounciness = (ref_body->get_bounciness() + inc_body->get_bounciness()) / 2;
-
-
-
-
-        // Force experienced by the ref body due to the inc body (and vice-versa)
-        Vec2D ref_force = ref_velocity_change * reference_mass * bounciness / delta_t;
-        Vec2D inc_force = inc_velocity_change * incident_mass * bounciness / delta_t;
+    }
 
 
-        // Apply collision force
-        ref_body->register_force(ref_force, point - ref_body->get_center());
-        inc_body->register_force(inc_force, point - inc_body->get_center());
+    void CollisionResolver::match_impulses(ContactConstraint &contact, const ContactConstraint &previous) {
+        const SATResult& r = contact.result;
+        const SATResult& p = previous.result;
 
+        for (int i=0; i<r.nb_collision_points; i++) {
+            for (int j=0; j<p.nb_collision_points; j++) {
+                if (Vec2D::distance_squared(r.collision_points[i], p.collision_points[j])
+                    > WARM_START_DISTANCE * WARM_START_DISTANCE) {continue;}
 
-        /*if (col_result.ref_body->is_static) {
-            col_result.inc_body->register_force(inc_force, point - col_result.ref_body->get_center());
-        }
-        else if (col_result.inc_body->is_static) {
-            Vec2D force = ref_force / col_result.nb_collision_points;
-            for (int i=0; i<col_result.nb_collision_points; i++) {
-                Vec2D rel_pos = col_result.collision_points[i] - ref_body->get_center();
-                ref_body->register_force(force, rel_pos);
+                // If the reference & incident bodies were swapped since the last step, the normal & tangent are
+                // reversed too, so the impulses still apply to the right bodies.
+                contact.normal_impulses[i] = previous.normal_impulses[j];
+                contact.tangent_impulses[i] = previous.tangent_impulses[j];
+                break;
             }
         }
-        else {
-            for (int i=0; i<col_result.nb_collision_points; i++) {
-                Vec2D rel_pos_ref = col_result.collision_points[i] - ref_body->get_center();
-                Vec2D rel_pos_inc = col_result.collision_points[i] - inc_body->get_center();
-                inc_body->register_force(inc_force / col_result.nb_collision_points, rel_pos_inc);
-                ref_body->register_force(ref_force / col_result.nb_collision_points, rel_pos_ref);
-            }
-        }*/
     }
 
 
-
-
-
-    void CollisionResolver::collision(const SATResult &col_result, double delta_t) {
-        for (int i=0; i<col_result.nb_collision_points; i++) {
-            point_collision(col_result, delta_t, i);
+    void CollisionResolver::warm_start(BodyStorage &bodies, const ContactConstraint &contact) {
+        const Vec2D& n = contact.result.minimum_penetration_vector;
+        for (int i=0; i<contact.result.nb_collision_points; i++) {
+            apply_impulse(bodies, contact, i, n * contact.normal_impulses[i] + contact.tangent * contact.tangent_impulses[i]);
         }
     }
 
 
-
-
-
-
-
-    void CollisionResolver::friction(const SATResult &col_result, double delta_t) {
-        std::shared_ptr<Body> ref_body = col_result.reference_shape->get_body();
-        std::shared_ptr<Body> inc_body = col_result.incident_shape->get_body();
-
-
+    void CollisionResolver::solve_velocity(BodyStorage &bodies, ContactConstraint &contact) {
+        const Vec2D& n = contact.result.minimum_penetration_vector;
+
+        for (int i=0; i<contact.result.nb_collision_points; i++) {
+            // Normal impulse. The accumulated impulse can only push the bodies apart.
+            real normal_velocity = Vec2D::dot(relative_velocity(bodies, contact, i), n);
+            real lambda = contact.normal_masses[i] * (contact.target_velocities[i] - normal_velocity);
+            real accumulated = std::max<real>(contact.normal_impulses[i] + lambda, 0);
+            lambda = accumulated - contact.normal_impulses[i];
+            contact.normal_impulses[i] = accumulated;
+            apply_impulse(bodies, contact, i, n * lambda);
+
+            // Friction impulse, limited by the normal impulse
+            real tangent_velocity = Vec2D::dot(relative_velocity(bodies, contact, i), contact.tangent);
+            real max_friction = contact.friction * contact.normal_impulses[i];
+            lambda = -contact.tangent_masses[i] * tangent_velocity;
+            accumulated = std::clamp(contact.tangent_impulses[i] + lambda, -max_friction, max_friction);
+            lambda = accumulated - contact.tangent_impulses[i];
+            contact.tangent_impulses[i] = accumulated;
+            apply_impulse(bodies, contact, i, contact.tangent * lambda);
+        }
     }
 
 
-    void CollisionResolver::separate(const SATResult &col_result) {
-        std::shared_ptr<Body> ref_body = col_result.reference_shape->get_body();
-        std::shared_ptr<Body> inc_body = col_result.incident_shape->get_body();
-
-        Vec2D min_pen_vec_normalised = col_result.minimum_penetration_vector.normalized();
-
-        // Move the shapes so they are not intersecting.
-        Vec2D correction_vector = min_pen_vec_normalised * col_result.depth;
-
-        // The correction is weighted by the velocity of each body towards the other.
-        Vec2D ref_towards_inc = (inc_body->get_center() - ref_body->get_center()).normalized();
-        Vec2D inc_towards_ref = (ref_body->get_center() - inc_body->get_center()).normalized();
+    void CollisionResolver::solve_positions(
+            const BodyStorage &bodies,
+            const CountedVector<ContactConstraint> &contacts,
+            CountedVector<Vec2D> &deltas,
+            int iterations,
+            real slop,
+            real delta_t
+            ) {
+        for (int it=0; it<iterations; it++) {
+            for (auto& contact: contacts) {
+                const SATResult& c = contact.result;
+                if (c.nb_collision_points == 0) {continue;}
+
+                int ref = contact.ref_index;
+                int inc = contact.inc_index;
+
+                real ref_inv_mass = bodies.inv_masses[ref];
+                real inc_inv_mass = bodies.inv_masses[inc];
+                real inv_mass_sum = ref_inv_mass + inc_inv_mass;
+                if (inv_mass_sum == 0) {continue;}
+
+                Vec2D& ref_delta = deltas[ref];
+                Vec2D& inc_delta = deltas[inc];
+
+                // The minimum penetration vector points from the incident body towards the reference body:
+                // the reference body moves along it and the incident body the other way.
+                // The current penetration takes into account the integration of the bodies since the detection,
+                // and the displacements computed so far.
+                Vec2D min_pen_vec = c.minimum_penetration_vector;
+                Vec2D integration = (bodies.velocities[ref] - bodies.velocities[inc]) * delta_t;
+                real depth = c.depth - Vec2D::dot(integration + ref_delta - inc_delta, min_pen_vec);
+
+                real correction = depth - slop;
+                if (correction <= 0) {continue;}
+
+                ref_delta += min_pen_vec * (correction * ref_inv_mass / inv_mass_sum);
+                inc_delta -= min_pen_vec * (correction * inc_inv_mass / inv_mass_sum);
+            }
+        }
+    }
 
-        double ref_rel_vel = Vec2D::dot(ref_towards_inc, ref_body->velocity);
-        if (ref_rel_vel < 0) {ref_rel_vel = 0;}
-        double inc_rel_vel = Vec2D::dot(inc_towards_ref, inc_body->velocity);
-        if (inc_rel_vel < 0) {inc_rel_vel = 0;}
 
-        // Both should not be negative, because in that case the collision wouldn't be detected.
-        double speed_sum = ref_rel_vel + inc_rel_vel;
+    void CollisionResolver::apply_impulse(
+            BodyStorage &bodies, const ContactConstraint &contact, int point_idx, const Vec2D &impulse
+            ) {
+        int ref = contact.ref_index;
+        int inc = contact.inc_index;
 
-        if (speed_sum == 0) {
-            std::cout << "speed sum equal to 0" << std::endl;
-            return;
-        }
+        // The inverses of the mass & inertia are 0 for static & kinematic bodies, so they won't be affected.
+        bodies.velocities[ref] += impulse * bodies.inv_masses[ref];
+        bodies.angular_velocities[ref] += Vec2D::cross(contact.ref_arms[point_idx], impulse) * bodies.inv_inertias[ref];
+        bodies.velocities[inc] -= impulse * bodies.inv_masses[inc];
+        bodies.angular_velocities[inc] -= Vec2D::cross(contact.inc_arms[point_idx], impulse) * bodies.inv_inertias[inc];
+    }
 
-        if (ref_body->is_static) {
-            inc_body->move(inc_body->get_center() - correction_vector);
-        }
-        else if (inc_body->is_static) {
-            ref_body->move(ref_body->get_center() + correction_vector);
-        }
-        else {
-            double ref_body_speed_ratio = ref_rel_vel / speed_sum;
-            double inc_body_speed_ratio = 1 - ref_body_speed_ratio;
-            std::cout << "ref_body_speed_ratio: " << ref_body_speed_ratio << std::endl;
-            inc_body->move(inc_body->get_center() - correction_vector * inc_body_speed_ratio);
-            ref_body->move(ref_body->get_center() + correction_vector * ref_body_speed_ratio);
-        }
+    Vec2D CollisionResolver::relative_velocity(
+            const BodyStorage &bodies, const ContactConstraint &contact, int point_idx
+            ) {
+        int ref = contact.ref_index;
+        int inc = contact.inc_index;
+        Vec2D ref_velocity = bodies.velocities[ref]
+                + Vec2D::cross(bodies.angular_velocities[ref], contact.ref_arms[point_idx]);
+        Vec2D inc_velocity = bodies.velocities[inc]
+                + Vec2D::cross(bodies.angular_velocities[inc], contact.inc_arms[point_idx]);
+        return ref_velocity - inc_velocity;
     }
-} // Msfl2D
\ No newline at end of file
+} // Msfl2D
@@ -7,37 +7,127 @@
 
 #include "CollisionDetector.hpp"
 #include "Body.hpp"
+#include "BodyStorage.hpp"
+
+#include <vector>
 
 namespace Msfl2D {
 
-    /** This static class is used to resolve collision by separating the bodies and applying correct forces to them. */
+    /**
+     * Contact between 2 bodies, as solved by the CollisionResolver. It stores the result of the collision detection
+     * along with the values used by the solver, and the impulses applied at each contact point.
+     */
+    struct ContactConstraint {
+        SATResult result;
+
+        // IDs of the 2 bodies, the smallest first, identifying the contact from one step to another, and whether
+        // the first one is the reference body
+        BodyID body1_id;
+        BodyID body2_id;
+        bool body1_is_ref;
+
+        // Rows of the reference & incident bodies in the storage of the World
+        int ref_index;
+        int inc_index;
+
+        real friction;
+        real bounciness;
+
+        // Largest speed at which the bodies approach each other along the normal at the contact points, when the
+        // contact is detected
+        real approach_speed = 0;
+
+        // Direction of the friction, perpendicular to the minimum penetration vector
+        Vec2D tangent;
+
+        // Position of each contact point relative to the body centers
+        Vec2D ref_arms[2];
+        Vec2D inc_arms[2];
+
+        // Effective masses & target normal velocity of each contact point
+        real normal_masses[2] = {0, 0};
+        real tangent_masses[2] = {0, 0};
+        real target_velocities[2] = {0, 0};
+
+        // Impulses accumulated at each contact point
+        real normal_impulses[2] = {0, 0};
+        real tangent_impulses[2] = {0, 0};
+
+        ContactConstraint(const SATResult& result, BodyID id1, BodyID id2);
+    };
+
+
+    /**
+     * This static class is used to resolve collision by separating the bodies and applying correct impulses to them.
+     *
+     * The velocities are solved with sequential impulses: each contact point is visited several times, and the impulse
+     * applied to the bodies is corrected at each visit, until the whole set of contacts (and joints) converges.
+     */
     class CollisionResolver {
     public:
 
-        /** Precision of approaching detection */
-        static constexpr double APPROACHING_PRECISION = 0.01;
+        /** Minimum approach speed for a collision to bounce. Slower contacts just come to rest. */
+        static constexpr real RESTITUTION_THRESHOLD = 1;
+
+        /** Maximum distance between 2 contact points of consecutive steps considered as the same point */
+        static constexpr real WARM_START_DISTANCE = 0.05;
 
         /**
-         * Resolve the collision. This is done in 3 steps:
-         * - Compute collision forces
-         * - Separate the intersecting bodies
-         * - Apply friction
+         * Compute the values used by the solver which are constant during the step: arms of the contact points,
+         * effective masses, and target velocity along the minimum penetration vector (bounce for collisions,
+         * or allowed approach speed for speculative contacts).
          */
-        static void resolve(const SATResult& col_result, double delta_t);
+        static void prepare(const BodyStorage& bodies, ContactConstraint& contact, real delta_t);
 
-    private:
+        /**
+         * Copy the impulses of the contact points of the last step to the matching points of the current step,
+         * so the solver starts from the last solution.
+         */
+        static void match_impulses(ContactConstraint& contact, const ContactConstraint& previous);
 
-        /** Separate the 2 colliding bodies */
-        static void separate(const SATResult& col_result);
+        /**
+         * Apply the impulses accumulated by the contact (see match_impulses()).
+         */
+        static void warm_start(BodyStorage& bodies, const ContactConstraint& contact);
 
-        /** Resolve collision force */
-        static void collision(const SATResult& col_result, double delta_t);
+        /**
+         * Compute & apply the impulses correcting the relative velocity of the bodies at each contact point:
+         * the normal impulse stops them from approaching each other, the tangent impulse applies friction.
+         * Called once per solver iteration.
+         */
+        static void solve_velocity(BodyStorage& bodies, ContactConstraint& contact);
+
+        /**
+         * Compute the displacement of each body required to separate the intersecting shapes of the given contacts.
+         * Every contact is visited once per iteration, and takes into account the displacements computed so far
+         * for its bodies, so that stacked bodies are all separated without moving them once per contact.
+         * The correction is distributed according to the masses of the bodies.
+         * @param bodies storage of the bodies of the contacts
+         * @param contacts contacts of the current update step, detected before the bodies were integrated
+         * @param deltas scratch buffer, indexed by the rows of the bodies and filled with zeros, in which the
+         *        displacement of each body is accumulated. It is the caller's job to apply them.
+         * @param iterations number of times each contact is visited
+         * @param slop penetration depth allowed between the shapes, which keeps resting contacts alive between steps.
+         * @param delta_t duration of the step, used to account for the integration of the bodies since the detection.
+         */
+        static void solve_positions(
+                const BodyStorage& bodies,
+                const CountedVector<ContactConstraint>& contacts,
+                CountedVector<Vec2D>& deltas,
+                int iterations,
+                real slop,
+                real delta_t
+                );
+
+    private:
 
-        /** Resolve collision for the specified collision point in col_result */
-        static void point_collision(const SATResult& col_result, double delta_t, int point_idx);
+        /** Apply the impulse to the reference body at the contact point, and the opposite one to the incident body */
+        static void apply_impulse(
+                BodyStorage& bodies, const ContactConstraint& contact, int point_idx, const Vec2D& impulse
+                );
 
-        /** Resolve friction to the collision */
-        static void friction(const SATResult& col_result, double delta_t);
+        /** Return the velocity of the reference body relative to the incident body at the contact point */
+        static Vec2D relative_velocity(const BodyStorage& bodies, const ContactConstraint& contact, int point_idx);
     };
 
 } // Msfl2D
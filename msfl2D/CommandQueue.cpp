@@ -0,0 +1,149 @@
+//
+// Created by myselfleo on 31/07/2023.
+//
+
+#include "CommandQueue.hpp"
+#include "MsflExceptions.hpp"
+
+namespace Msfl2D {
+    namespace {
+        /**
+         * Return the index of the node of a list head.
+         */
+        std::uint32_t head_node(std::uint64_t head) {
+            return static_cast<std::uint32_t>(head);
+        }
+
+        /**
+         * Return the head following `head`, pointing to the given node.
+         */
+        std::uint64_t next_head(std::uint64_t head, std::uint32_t node) {
+            return ((head >> 32) + 1) << 32 | node;
+        }
+    }
+
+
+    CommandQueue::CommandQueue(std::shared_ptr<MemoryCounter> counter): counter(std::move(counter)) {}
+
+    CommandQueue::~CommandQueue() {
+        for (std::uint32_t i=0; i<nb_chunks.load(); i++) {
+            delete[] chunks[i].load();
+            if (counter != nullptr) {counter->remove(get_chunk_size(i) * sizeof(Node));}
+        }
+    }
+
+
+    void CommandQueue::add_body(std::shared_ptr<Body> body) {
+        push({CommandType::ADD_BODY, 0, Vec2D::ZERO, Vec2D::ZERO, 0, std::move(body)});
+    }
+
+    void CommandQueue::remove_body(BodyID id) {
+        push({CommandType::REMOVE_BODY, id, Vec2D::ZERO, Vec2D::ZERO, 0, nullptr});
+    }
+
+    void CommandQueue::move(BodyID id, const Vec2D &position) {
+        push({CommandType::MOVE, id, position, Vec2D::ZERO, 0, nullptr});
+    }
+
+    void CommandQueue::apply_impulse(BodyID id, const Vec2D &impulse, const Vec2D &application_point) {
+        push({CommandType::APPLY_IMPULSE, id, impulse, application_point, 0, nullptr});
+    }
+
+    void CommandQueue::set_velocity(BodyID id, const Vec2D &velocity, real angular_velocity) {
+        push({CommandType::SET_VELOCITY, id, velocity, Vec2D::ZERO, angular_velocity, nullptr});
+    }
+
+    void CommandQueue::push(const Command &command) {
+        // The node is only reachable by this thread until it is pushed
+        std::uint32_t node = take_free_node();
+        get_node(node).command = command;
+        push_list(pending_head, node, node);
+    }
+
+
+    std::uint32_t CommandQueue::get_chunk_size(std::uint32_t chunk) {
+        return FIRST_CHUNK_SIZE << chunk;
+    }
+
+    CommandQueue::Node &CommandQueue::get_node(std::uint32_t index) const {
+        // The chunk k starts at the index FIRST_CHUNK_SIZE * (2^k - 1)
+        std::uint32_t n = index / FIRST_CHUNK_SIZE + 1;
+        std::uint32_t chunk = 0;
+        while (n >> (chunk + 1)) {chunk++;}
+
+        std::uint32_t offset = index - FIRST_CHUNK_SIZE * ((1u << chunk) - 1);
+        return chunks[chunk].load(std::memory_order_acquire)[offset];
+    }
+
+    std::uint32_t CommandQueue::take_free_node() {
+        std::uint64_t head = free_head.load(std::memory_order_acquire);
+        while (true) {
+            std::uint32_t node = head_node(head);
+            if (node == NIL) {
+                add_chunk(nb_chunks.load(std::memory_order_acquire));
+                head = free_head.load(std::memory_order_acquire);
+                continue;
+            }
+
+            // The node may be taken by another thread in the meantime; its next node is then wrong, but the head
+            // has changed, so the exchange fails
+            std::uint32_t next = get_node(node).next.load(std::memory_order_relaxed);
+            if (free_head.compare_exchange_weak(head, next_head(head, next), std::memory_order_acquire)) {return node;}
+        }
+    }
+
+    void CommandQueue::add_chunk(std::uint32_t chunk) {
+        if (chunk == MAX_CHUNKS) {throw SimulationException("Too many commands waiting in the queue");}
+
+        // Another thread may have published the chunk without having counted it yet
+        if (chunks[chunk].load(std::memory_order_acquire) != nullptr) {
+            nb_chunks.compare_exchange_strong(chunk, chunk + 1);
+            return;
+        }
+
+        std::uint32_t size = get_chunk_size(chunk);
+        Node* nodes = new Node[size];
+        Node* expected = nullptr;
+        if (!chunks[chunk].compare_exchange_strong(expected, nodes, std::memory_order_acq_rel)) {
+            delete[] nodes;
+            nb_chunks.compare_exchange_strong(chunk, chunk + 1);
+            return;
+        }
+        if (counter != nullptr) {counter->add(size * sizeof(Node));}
+
+        std::uint32_t first = FIRST_CHUNK_SIZE * ((1u << chunk) - 1);
+        for (std::uint32_t i=0; i<size - 1; i++) {nodes[i].next.store(first + i + 1, std::memory_order_relaxed);}
+        nb_chunks.compare_exchange_strong(chunk, chunk + 1);
+        push_list(free_head, first, first + size - 1);
+    }
+
+    void CommandQueue::push_list(std::atomic<std::uint64_t> &head, std::uint32_t first, std::uint32_t last) {
+        Node& last_node = get_node(last);
+        std::uint64_t current = head.load(std::memory_order_relaxed);
+        do {
+            last_node.next.store(head_node(current), std::memory_order_relaxed);
+        } while (!head.compare_exchange_weak(current, next_head(current, first), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    std::uint32_t CommandQueue::take_all(std::uint32_t &last) {
+        std::uint64_t head = pending_head.load(std::memory_order_relaxed);
+        while (!pending_head.compare_exchange_weak(head, next_head(head, NIL), std::memory_order_acquire)) {}
+
+        // The commands are linked from the most recent one: reverse the list
+        std::uint32_t node = head_node(head);
+        std::uint32_t previous = NIL;
+        last = node;
+        while (node != NIL) {
+            std::uint32_t next = get_node(node).next.load(std::memory_order_relaxed);
+            get_node(node).next.store(previous, std::memory_order_relaxed);
+            previous = node;
+            node = next;
+        }
+        return previous;
+    }
+
+    void CommandQueue::release(std::uint32_t first, std::uint32_t last) {
+        if (first == NIL) {return;}
+        push_list(free_head, first, last);
+    }
+} // Msfl2D
@@ -0,0 +1,191 @@
+//
+// Created by myselfleo on 31/07/2023.
+//
+
+#ifndef MSFL2D_COMMANDQUEUE_HPP
+#define MSFL2D_COMMANDQUEUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "Body.hpp"
+#include "MemoryStats.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * Type of a change of a world requested through its CommandQueue.
+     */
+    enum class CommandType: unsigned char {
+        /** Add `body` to the world */
+        ADD_BODY,
+        /** Remove the body `id` from the world */
+        REMOVE_BODY,
+        /** Move the center of the body `id` to `vector` */
+        MOVE,
+        /** Apply the impulse `vector` at the point `point` (relative to the center) of the body `id` */
+        APPLY_IMPULSE,
+        /** Set the velocity of the body `id` to `vector`, and its angular velocity to `angular_velocity` */
+        SET_VELOCITY
+    };
+
+
+    /**
+     * Change of a world waiting in a CommandQueue. The meaning of the values depends on its type.
+     */
+    struct Command {
+        CommandType type;
+        BodyID id;
+        Vec2D vector;
+        Vec2D point;
+        real angular_velocity;
+        std::shared_ptr<Body> body;
+    };
+
+
+    /**
+     * Queue of changes to apply to a world, which any number of threads can push to at the same time, including
+     * while the world is being updated. The world executes the commands at the start of its next step, in the
+     * order they were pushed.
+     *
+     * The queue is lock-free: pushing a command never waits for another thread. The commands are stored in nodes
+     * allocated by chunks, which are never freed until the queue is destroyed; the nodes of the executed commands
+     * are reused, so once warm, pushing doesn't allocate memory.
+     */
+    class CommandQueue {
+    public:
+        /**
+         * Create an empty queue, counting the memory of its nodes in the given counter if it is not null.
+         */
+        explicit CommandQueue(std::shared_ptr<MemoryCounter> counter = nullptr);
+
+        ~CommandQueue();
+
+        CommandQueue(const CommandQueue&) = delete;
+        CommandQueue& operator=(const CommandQueue&) = delete;
+
+        /**
+         * Push a command adding the body to the world. The body is ignored if it is in a world by then.
+         */
+        void add_body(std::shared_ptr<Body> body);
+
+        /**
+         * Push a command removing a body from the world. The commands on bodies which don't exist anymore when
+         * they are executed are ignored; this is the case for the following ones.
+         */
+        void remove_body(BodyID id);
+
+        /**
+         * Push a command moving the center of a body to the given position (see Body::move()).
+         */
+        void move(BodyID id, const Vec2D& position);
+
+        /**
+         * Push a command applying an impulse to a body (see Body::apply_impulse()).
+         */
+        void apply_impulse(BodyID id, const Vec2D& impulse, const Vec2D& application_point);
+
+        /**
+         * Push a command setting the velocity & the angular velocity of a body.
+         */
+        void set_velocity(BodyID id, const Vec2D& velocity, real angular_velocity);
+
+        /**
+         * Push a command. Throws SimulationException if too many commands (about 16 millions) are waiting.
+         */
+        void push(const Command& command);
+
+        /**
+         * Call function(command) for each command pushed so far, in the order they were pushed, and remove them
+         * from the queue. It must only be called by one thread at a time.
+         * If the function throws, the commands not executed yet are removed anyway.
+         * @return the number of commands executed
+         */
+        template<typename F>
+        int execute(const F& function) {
+            std::uint32_t last;
+            std::uint32_t first = take_all(last);
+            int count = 0;
+
+            try {
+                for (std::uint32_t node = first; node != NIL; node = get_node(node).next.load(std::memory_order_relaxed)) {
+                    Command& command = get_node(node).command;
+                    function(command);
+                    command.body = nullptr;
+                    count++;
+                }
+            }
+            catch (...) {
+                release(first, last);
+                throw;
+            }
+
+            release(first, last);
+            return count;
+        }
+
+    private:
+        struct Node {
+            Command command;
+            std::atomic<std::uint32_t> next{NIL};
+        };
+
+        static constexpr std::uint32_t NIL = 0xFFFFFFFF;
+
+        // Each chunk holds twice as many nodes as the previous one
+        static constexpr std::uint32_t FIRST_CHUNK_SIZE = 256;
+        static constexpr std::uint32_t MAX_CHUNKS = 16;
+
+        // Chunks of nodes, the first nb_chunks being allocated. A node is identified by its index over all chunks.
+        std::atomic<Node*> chunks[MAX_CHUNKS] = {};
+        std::atomic<std::uint32_t> nb_chunks{0};
+
+        // Heads of the lists of free nodes & of pushed commands (most recent first), linked by their indices. Each
+        // head is a node index in the lowest 32 bits, and a counter incremented at each change in the highest
+        // ones: a thread which read a head that changed since then fails to update it, even if the same node is
+        // back at the head.
+        std::atomic<std::uint64_t> free_head{NIL};
+        std::atomic<std::uint64_t> pending_head{NIL};
+
+        std::shared_ptr<MemoryCounter> counter;
+
+        /**
+         * Return the number of nodes of the chunk with the given index.
+         */
+        static std::uint32_t get_chunk_size(std::uint32_t chunk);
+
+        Node& get_node(std::uint32_t index) const;
+
+        /**
+         * Remove a node from the free list and return its index, allocating a new chunk if needed.
+         * Throws SimulationException if every chunk is allocated & in use.
+         */
+        std::uint32_t take_free_node();
+
+        /**
+         * Allocate the chunk with the given index, and add its nodes to the free list. Does nothing if another
+         * thread allocated it in the meantime.
+         */
+        void add_chunk(std::uint32_t chunk);
+
+        /**
+         * Add the nodes linked from `first` to `last` to the front of the list with the given head.
+         */
+        void push_list(std::atomic<std::uint64_t>& head, std::uint32_t first, std::uint32_t last);
+
+        /**
+         * Remove every pushed command, and return the index of the first one, and of the last one in `last`.
+         * They are linked in the order they were pushed.
+         */
+        std::uint32_t take_all(std::uint32_t& last);
+
+        /**
+         * Give the nodes linked from `first` to `last` back to the free list.
+         */
+        void release(std::uint32_t first, std::uint32_t last);
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_COMMANDQUEUE_HPP
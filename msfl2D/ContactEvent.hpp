@@ -0,0 +1,47 @@
+//
+// Created by myselfleo on 01/08/2023.
+//
+
+#ifndef MSFL2D_CONTACTEVENT_HPP
+#define MSFL2D_CONTACTEVENT_HPP
+
+#include "Body.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * Change of the contact between 2 bodies during a step. Speculative contacts (shapes close to each other but not
+     * touching yet) don't count as touching.
+     */
+    enum class ContactEventType: unsigned char {
+        /** The bodies started touching during the step */
+        BEGIN,
+        /** The bodies were already touching at the last step, and still are */
+        PERSIST,
+        /** The bodies were touching at the last step, and aren't anymore (or one of them was removed) */
+        END
+    };
+
+
+    /**
+     * Event of the contact between 2 bodies, produced at each step while they touch (see World::get_contact_events()).
+     * @param body1_id ID of the first body, the smallest of both
+     * @param normal Direction of the contact, normalized, pointing from the first body towards the second one
+     * @param depth Penetration depth of the contact when it was detected
+     * @param approach_speed Speed at which the bodies were approaching each other along the normal when the contact
+     *                       was detected, before the solver separated them. It is the largest speed of the contact
+     *                       points, and is negative when they were already moving apart.
+     *                       The END events carry the values of the last step the bodies were touching.
+     */
+    struct ContactEvent {
+        ContactEventType type;
+        BodyID body1_id;
+        BodyID body2_id;
+        Vec2D normal;
+        real depth;
+        real approach_speed;
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_CONTACTEVENT_HPP
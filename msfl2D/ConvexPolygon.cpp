@@ -2,7 +2,9 @@
 // Created by myselfleo on 14/06/23.
 //
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include "ConvexPolygon.hpp"
 #include "Line.hpp"
 #include "MsflExceptions.hpp"
@@ -10,75 +12,160 @@
 namespace Msfl2D {
 
     ConvexPolygon::ConvexPolygon(const std::vector<Vec2D> &vertices, Vec2D zero) {
-        this->rotation = 0;
         this->body = nullptr;
 
         // Add the given vertices to the shape, adding the zero coordinates to it (make it absolute).
         // At that point, the vertices coordinates are absolute; we'll make them relative to the center later
         // (we first need to compute it)
+        std::vector<Vec2D> relative_vertices;
         for (auto& v: vertices) {
-            this->vertices.push_back(v + zero);
+            relative_vertices.push_back(v + zero);
         }
 
         // Compute the center of the polygon.
-        this->position = vec2D_average(this->vertices);
+        this->transform.translation = vec2D_average(relative_vertices);
 
         // Update the vertices so that they are relative to the center of the ConvexPolygon
-        for (auto& v: this->vertices) {
-            v -= this->position;
+        for (auto& v: relative_vertices) {
+            v -= this->transform.translation;
         }
+        init_vertices(relative_vertices);
 
         if (!is_convex()) {
             throw GeometryException("The vertices do not form a convex polygon.");
         }
+
+        compute_mass_properties();
     }
 
 
     ConvexPolygon::ConvexPolygon(const std::vector<Vec2D> &vertices) {
-        this->rotation = 0;
         this->body = nullptr;
 
         // Compute the center of the polygon.
-        this->position = vec2D_average(vertices);
+        this->transform.translation = vec2D_average(vertices);
 
         // Convert the absolution position of the vertices into relative ones.
+        std::vector<Vec2D> relative_vertices;
         for (auto& v: vertices) {
-            this->vertices.push_back(v - this->position);
+            relative_vertices.push_back(v - this->transform.translation);
         }
+        init_vertices(relative_vertices);
 
         if (!is_convex()) {
             throw GeometryException("The vertices do not form a convex polygon.");
         }
+
+        compute_mass_properties();
     }
 
 
 
-    ConvexPolygon::ConvexPolygon(unsigned int vertex_nb, double circumradius, Vec2D center) {
+    ConvexPolygon::ConvexPolygon(unsigned int vertex_nb, real circumradius, Vec2D center) {
         if (vertex_nb < 3) {throw GeometryException("Cannot create a ConvexPolygon with less than 3 vertices.");}
         if (circumradius <= 0) {throw GeometryException("The circumradius of a ConvexPolygon must be > 0");}
 
-        this->position = center;
-        this->rotation = 0;
+        this->transform.translation = center;
         this->body = nullptr;
 
+        std::vector<Vec2D> relative_vertices;
         for (int i=0; i<vertex_nb; i++) {
-            double rad = i * -2 * M_PI / vertex_nb;
-            Vec2D dir_vec = {cos(rad), sin(rad)};
-            this->vertices.push_back(dir_vec * circumradius);
+            real rad = i * -2 * M_PI / vertex_nb;
+            Vec2D dir_vec = {std::cos(rad), std::sin(rad)};
+            relative_vertices.push_back(dir_vec * circumradius);
+        }
+        init_vertices(relative_vertices);
+
+        compute_mass_properties();
+    }
+
+
+    ConvexPolygon::ConvexPolygon(const ConvexPolygon &other): Shape(other) {
+        this->body = nullptr;
+        init_vertices(std::vector<Vec2D>(other.local_vertices, other.local_vertices + other.vertex_count));
+    }
+
+
+    ConvexPolygon::~ConvexPolygon() {
+        if (storage != nullptr) {storage->remove(vertex_range);}
+    }
+
+
+    void ConvexPolygon::init_vertices(const std::vector<Vec2D> &vertices) {
+        vertex_count = vertices.size();
+        own_vertices = std::make_unique<Vec2D[]>(vertex_count * 2);
+        local_vertices = own_vertices.get();
+        world_vertices = own_vertices.get() + vertex_count;
+
+        std::copy(vertices.begin(), vertices.end(), local_vertices);
+        transform_changed();
+    }
+
+
+    void ConvexPolygon::set_vertex_range(VertexStorage *new_storage, int range, int offset) {
+        storage = new_storage;
+        vertex_range = range;
+        local_vertices = new_storage->local_vertices.data() + offset;
+        world_vertices = new_storage->world_vertices.data() + offset;
+    }
+
+
+    void ConvexPolygon::transform_changed() {
+        for (int i=0; i<vertex_count; i++) {
+            world_vertices[i] = transform.apply(local_vertices[i]);
         }
     }
 
 
+    void ConvexPolygon::attach(VertexStorage &new_storage) {
+        if (&new_storage == storage) {return;}
+
+        // The old vertices don't move while the range is added, as they are not in the new storage
+        VertexStorage* old_storage = storage;
+        int old_range = vertex_range;
+        const Vec2D* old_local = local_vertices;
+        const Vec2D* old_world = world_vertices;
+        new_storage.add(this, vertex_count);
+
+        std::copy_n(old_local, vertex_count, local_vertices);
+        std::copy_n(old_world, vertex_count, world_vertices);
+
+        if (old_storage != nullptr) {old_storage->remove(old_range);}
+        own_vertices.reset();
+    }
+
+
+    void ConvexPolygon::detach() {
+        if (storage == nullptr) {return;}
+
+        auto new_vertices = std::make_unique<Vec2D[]>(vertex_count * 2);
+        std::copy_n(local_vertices, vertex_count, new_vertices.get());
+        std::copy_n(world_vertices, vertex_count, new_vertices.get() + vertex_count);
+        release();
+
+        own_vertices = std::move(new_vertices);
+        local_vertices = own_vertices.get();
+        world_vertices = own_vertices.get() + vertex_count;
+    }
+
+
+    void ConvexPolygon::release() {
+        if (storage == nullptr) {return;}
+        storage->remove(vertex_range);
+        storage = nullptr;
+        local_vertices = nullptr;
+        world_vertices = nullptr;
+    }
 
 
     LineSegment ConvexPolygon::project(const Line &line) const {
-        double min = (get_global_vertex(0)).project(line); // add the center of the polygon to get the global position of each vertices
-        double max = min;
+        real min = (get_global_vertex(0)).project(line); // add the center of the polygon to get the global position of each vertices
+        real max = min;
 
         // We project each vertex of the polygon. We keep the minimal and maximal point (the one closest to the line's
         // zero and the farest one)
         for (int i=0; i<nb_vertices(); i++) {
-            double proj = get_global_vertex(i).project(line);
+            real proj = get_global_vertex(i).project(line);
             if (proj < min) {min = proj;}
             if (proj > max) {max = proj;}
         }
@@ -87,6 +174,22 @@ namespace Msfl2D {
     }
 
 
+    AABB ConvexPolygon::get_aabb() const {
+        Vec2D first = get_global_vertex(0);
+        AABB res = {first, first};
+
+        for (int i=1; i<nb_vertices(); i++) {
+            Vec2D v = get_global_vertex(i);
+            if (v.x < res.min.x) {res.min.x = v.x;}
+            if (v.x > res.max.x) {res.max.x = v.x;}
+            if (v.y < res.min.y) {res.min.y = v.y;}
+            if (v.y > res.max.y) {res.max.y = v.y;}
+        }
+
+        return res;
+    }
+
+
     Vec2D ConvexPolygon::vec2D_average(const std::vector<Vec2D> &vectors) {
         Vec2D res = {0, 0};
         for (auto& v: vectors) {
@@ -105,10 +208,10 @@ namespace Msfl2D {
         LineSide expected_side = Line::side(p1, p2, p);
 
         // Now, we check that the point is at the same side for every other lines.
-        for (int i=1; i<vertices.size(); i++) {
+        for (int i=1; i<vertex_count; i++) {
             // Compute points of the line
             p1 = get_global_vertex(i);
-            p2 = get_global_vertex((i+1) % vertices.size());
+            p2 = get_global_vertex((i+1) % vertex_count);
             LineSide side = Line::side(p1, p2, p);
             // Only exit if the point is outside of the polygon.
             // The Shape class expects that "is_point_inside" returns true if the point is on the shape.
@@ -118,26 +221,69 @@ namespace Msfl2D {
         return true;
     }
 
+    bool ConvexPolygon::raycast(const Vec2D &from, const Vec2D &to, real max_fraction, real &fraction, Vec2D &normal) const {
+        // The ray is clipped by each side: it is inside the polygon between the last side it enters & the first
+        // side it exits.
+        Vec2D direction = to - from;
+        real enter = -std::numeric_limits<real>::infinity();
+        real exit = max_fraction;
+        Vec2D enter_normal;
+
+        for (int i=0; i<vertex_count; i++) {
+            const Vec2D& p1 = world_vertices[i];
+            const Vec2D& p2 = world_vertices[(i+1) % vertex_count];
+
+            // The vertices are clockwise, so this normal points outwards
+            Vec2D side_normal = {p1.y - p2.y, p2.x - p1.x};
+            real distance = Vec2D::dot(side_normal, p1 - from);
+            real speed = Vec2D::dot(side_normal, direction);
+
+            if (speed == 0) {
+                // Parallel to the side, and outside of it
+                if (distance < 0) {return false;}
+                continue;
+            }
+
+            real t = distance / speed;
+            if (speed < 0) {
+                if (t > enter) {
+                    enter = t;
+                    enter_normal = side_normal;
+                }
+            }
+            else if (t < exit) {exit = t;}
+
+            if (exit < enter) {return false;}
+        }
+
+        // A negative fraction means the ray starts inside the polygon
+        if (enter < 0) {return false;}
+
+        fraction = enter;
+        normal = enter_normal.normalized();
+        return true;
+    }
+
     bool ConvexPolygon::is_convex() const {
         // The polygon is convex if every inner angle acute.
         // We need the counterclockwise angle (as we are iterating over the vertices clockwise).
         // For that, we use the dot product, the determinant of the 2 vectors along with atan2; see below.
 
         // we just iterate over each vertex i, and we use as vectors the segments [i i-1] and [i i+1].
-        for (unsigned int i=0; i<vertices.size(); i++) {
+        for (unsigned int i=0; i<vertex_count; i++) {
             // modulo operator is cringe so i do it cringier. For some reason it works for i+1 tho
             unsigned int prev_i;
-            if (i == 0) {prev_i = vertices.size() - 1;}
+            if (i == 0) {prev_i = vertex_count - 1;}
             else {prev_i = i - 1;}
 
-            Vec2D a = vertices[prev_i] - vertices[i];
-            Vec2D b = vertices[(i+1) % vertices.size()] - vertices[i];
+            Vec2D a = local_vertices[prev_i] - local_vertices[i];
+            Vec2D b = local_vertices[(i+1) % vertex_count] - local_vertices[i];
 
             // in radians, > 0.
-            double dot = Vec2D::dot(a, b);
-            double det = Vec2D::det(a, b);
+            real dot = Vec2D::dot(a, b);
+            real det = Vec2D::det(a, b);
 
-            double angle = atan2(det, dot);
+            real angle = atan2(det, dot);
 
             // angle is > 0 is the inner angle is acute, < 0 other wise.
             if (angle < 0) {return false;}
@@ -146,24 +292,48 @@ namespace Msfl2D {
         return true;
     }
 
-    Vec2D &ConvexPolygon::get_vertex(int idx) {
-        if (idx > vertices.size() - 1) {throw GeometryException("Tried to access an inexistant vertex");}
-        return vertices[idx];
+    void ConvexPolygon::compute_mass_properties() {
+        // The polygon is split into triangles formed by the position of the polygon and each of its sides.
+        // The properties of the polygon are the sums of the (signed) properties of those triangles.
+        // The vertices being clockwise, every cross product is negative; we just flip the sign at the end.
+        real signed_area = 0;
+        Vec2D weighted_centroid = {0, 0};
+        real origin_inertia = 0;
+
+        for (int i=0; i<vertex_count; i++) {
+            const Vec2D& p1 = local_vertices[i];
+            const Vec2D& p2 = local_vertices[(i+1) % vertex_count];
+
+            real cross = Vec2D::cross(p1, p2);
+            signed_area += cross / 2;
+            weighted_centroid += (p1 + p2) * (cross / 6);
+            origin_inertia += cross * (Vec2D::dot(p1, p1) + Vec2D::dot(p1, p2) + Vec2D::dot(p2, p2)) / 12;
+        }
+
+        area = std::abs(signed_area);
+        centroid = weighted_centroid / signed_area;
+
+        // The inertia was computed around the position of the polygon; move it to the centroid
+        // (parallel axis theorem).
+        inertia = std::abs(origin_inertia) - area * Vec2D::dot(centroid, centroid);
     }
 
-    Vec2D ConvexPolygon::get_global_vertex(int idx) const {
-        if (idx > vertices.size() - 1) {throw GeometryException("Tried to access an inexistant vertex");}
-        Vec2D res = vertices[idx].rotate(rotation); // apply rotation
-        return res + position;                            // apply position
+    Vec2D &ConvexPolygon::get_vertex(int idx) {
+        if (idx > vertex_count - 1) {throw GeometryException("Tried to access an inexistant vertex");}
+        return local_vertices[idx];
+    }
 
+    const Vec2D& ConvexPolygon::get_global_vertex(int idx) const {
+        if (idx > vertex_count - 1) {throw GeometryException("Tried to access an inexistant vertex");}
+        return world_vertices[idx];
     }
 
     const Vec2D &ConvexPolygon::get_const_vertex(int idx) const {
-        if (idx > vertices.size() - 1) {throw GeometryException("Tried to access an inexistant vertex");}
-        return vertices[idx];
+        if (idx > vertex_count - 1) {throw GeometryException("Tried to access an inexistant vertex");}
+        return local_vertices[idx];
     }
 
     int ConvexPolygon::nb_vertices() const {
-        return vertices.size();
+        return vertex_count;
     }
 } // Msfl2D
\ No newline at end of file
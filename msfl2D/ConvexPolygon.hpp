@@ -6,12 +6,17 @@
 #define MSFL2D_CONVEXPOLYGON_HPP
 
 #include <vector>
+#include <memory>
 #include "Shape.hpp"
+#include "VertexStorage.hpp"
 
 namespace Msfl2D {
 
     /**
      * A convex polygon represented as a list of points relative to the polygon's center.
+     * The vertices are cached along with their world-space position. Once the polygon is added to a body, they are kept
+     * in the VertexStorage of the body (the storage of the World for the bodies in a World), so the vertices of every
+     * polygon of a World are contiguous.
      * A convex polygon only has inner angles equal or inferior to 180 degrees. Trying to construct a concave polygon
      * will result in a GeometryException being raised.
      * The convex aspect of the polygon is important in order to use the Separated Axis Theorem for collision detection.
@@ -41,16 +46,26 @@ namespace Msfl2D {
          * Construct a **regular** ConvexPolygon with the given number of vertex, the distance between
          * the center and the vertices (the circumradius) and the center position;
          */
-         ConvexPolygon(unsigned int vertex_nb, double circumradius, Vec2D center);
+         ConvexPolygon(unsigned int vertex_nb, real circumradius, Vec2D center);
 
-        ~ConvexPolygon() override = default;
+        /**
+         * Construct a copy of the given polygon, at the same position, not added to any body.
+         */
+        ConvexPolygon(const ConvexPolygon& other);
+
+        ~ConvexPolygon() override;
 
         LineSegment project(const Line &line) const override;
 
         bool is_point_inside(const Vec2D& p) const override;
 
+        AABB get_aabb() const override;
+
+        bool raycast(const Vec2D& from, const Vec2D& to, real max_fraction, real& fraction, Vec2D& normal) const override;
+
         /**
          * Return a reference to the polygon's vertex at the given index.
+         * The world-space position of a modified vertex is only updated the next time the polygon moves.
          * If the index is too great, this method throws a GeometryException.
          * @param idx index of the vertex to get
          * @return a reference to the vertex
@@ -59,9 +74,10 @@ namespace Msfl2D {
 
         /**
          * Return the global position of the given vertex, i.e with the shape's rotation and position taken into account.
+         * This position is cached, and updated each time the polygon moves.
          * If the index is too great, this method throws a GeometryException.
          */
-        Vec2D get_global_vertex(int idx) const;
+        const Vec2D& get_global_vertex(int idx) const;
 
         /**
          * Return a const reference to the polygon's vertex at the given index.
@@ -77,8 +93,37 @@ namespace Msfl2D {
         int nb_vertices() const;
 
 
+    protected:
+        void transform_changed() override;
+        void attach(VertexStorage& new_storage) override;
+        void detach() override;
+        void release() override;
+
     private:
-        std::vector<Vec2D> vertices;
+        friend class VertexStorage;
+
+        // Vertices of the polygon while it is not in a storage: the local vertices, followed by the world-space ones
+        std::unique_ptr<Vec2D[]> own_vertices;
+
+        // Storage holding the vertices (nullptr while the polygon holds them itself), and index of their range in it
+        VertexStorage* storage = nullptr;
+        int vertex_range = 0;
+
+        // Local & world-space vertices of the polygon, in its storage or in its own array
+        Vec2D* local_vertices = nullptr;
+        Vec2D* world_vertices = nullptr;
+        int vertex_count = 0;
+
+        /**
+         * Store the given vertices, relative to the polygon's center, in an array of its own.
+         * Called once by the constructors.
+         */
+        void init_vertices(const std::vector<Vec2D>& vertices);
+
+        /**
+         * Use the range of vertices at the given index & offset of the storage. Called by the storage.
+         */
+        void set_vertex_range(VertexStorage* new_storage, int range, int offset);
 
         /**
          * Returns the average position of the Vec2Ds.
@@ -90,6 +135,12 @@ namespace Msfl2D {
          * @return true if self is convex, false otherwise
          */
          bool is_convex() const;
+
+        /**
+         * Compute the area, the centroid and the polar moment of inertia of the polygon.
+         * Called once by the constructors.
+         */
+         void compute_mass_properties();
     };
 
 } // Msfl2D
@@ -0,0 +1,90 @@
+//
+// Created by myselfleo on 29/07/2023.
+//
+
+// Check that a world steps to the same state whatever the number of threads of its JobSystem: the same scene is
+// simulated with a single thread and with several ones, and the state hashes (see World::state_hash()) must match.
+// Returns 0 if they do, and 1 otherwise.
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "World.hpp"
+#include "ConvexPolygon.hpp"
+
+using namespace Msfl2D;
+
+namespace {
+    // Just enough bodies to run the integration (World::PARALLEL_INTEGRATION_THRESHOLD, 2048 bodies) and the
+    // narrow phase (World::PARALLEL_NARROWPHASE_THRESHOLD, 256 pairs) on the JobSystem, so the test stays fast in
+    // debug builds. The forces are only applied in parallel from World::PARALLEL_FORCES_THRESHOLD (8192 bodies), so
+    // that phase is not covered.
+    constexpr int BODY_COUNT = 2100;
+    constexpr int COLUMNS = 100;
+    constexpr int STEPS = 10;
+
+    /**
+     * Build the test scene in a world using the given number of threads, step it and return its state hash.
+     */
+    std::uint64_t simulate(int threads) {
+        World world(std::make_shared<JobSystem>(threads));
+        world.constant_force = Vec2D{0, -9.81};
+
+        BodyID ground_id = world.create_body();
+        auto ground = world.get_body(ground_id);
+        ground->add_shape(world.make_polygon(4u, 100, Vec2D{0, -70.7}));
+        ground->set_static(true);
+
+        // A pile of polygons, with various numbers of sides and spins
+        std::vector<BodyID> ids;
+        world.create_bodies(BODY_COUNT, ids);
+        for (int i=0; i<BODY_COUNT; i++) {
+            auto body = world.get_body(ids[i]);
+            Vec2D position = {real((i % COLUMNS) * 0.9 - 45), real(1 + (i / COLUMNS) * 0.9)};
+            body->add_shape(world.make_polygon(4u + i % 4, 0.5, position));
+            body->set_angular_velocity(real(0.3 * (i % 5)));
+        }
+
+        // Joints of every kind between neighbours
+        for (int i=0; i<BODY_COUNT - 1; i+=40) {
+            Vec2D position = world.get_body(ids[i])->get_center();
+            Vec2D next_position = world.get_body(ids[i + 1])->get_center();
+            switch ((i / 40) % 4) {
+                case 0: world.add_revolute_joint(ids[i], ids[i + 1], (position + next_position) / 2); break;
+                case 1: world.add_distance_joint(ids[i], ids[i + 1], position, next_position); break;
+                case 2: world.add_prismatic_joint(ids[i], ids[i + 1], position, Vec2D{1, 0}); break;
+                default: world.add_weld_joint(ids[i], ids[i + 1], (position + next_position) / 2); break;
+            }
+        }
+
+        // Removals leave holes in the storage, which the step must fill the same way on every thread count
+        for (int i=5; i<BODY_COUNT; i+=97) {
+            if (i % 40 > 1) {world.remove_body(ids[i]);}
+        }
+
+        for (int step=0; step<STEPS; step++) {
+            world.update(1 / real(60));
+            // Remove a body during the simulation too
+            if (step == STEPS / 2) {world.remove_body(ids[BODY_COUNT - 1]);}
+        }
+        return world.state_hash();
+    }
+}
+
+int main() {
+    std::uint64_t reference = simulate(1);
+    std::cout << "1 thread: " << std::hex << reference << std::endl;
+
+    bool success = true;
+    for (int threads: {2, 3, 8}) {
+        std::uint64_t hash = simulate(threads);
+        std::cout << std::dec << threads << " threads: " << std::hex << hash << std::endl;
+        if (hash != reference) {
+            std::cerr << "State hash differs from the single-threaded simulation with " << std::dec << threads
+                      << " threads" << std::endl;
+            success = false;
+        }
+    }
+    return success ? 0 : 1;
+}
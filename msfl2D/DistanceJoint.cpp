@@ -0,0 +1,58 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#include "DistanceJoint.hpp"
+#include "MsflExceptions.hpp"
+
+#include <utility>
+
+namespace Msfl2D {
+    DistanceJoint::DistanceJoint(
+            BodyID id1, std::shared_ptr<Body> b1,
+            BodyID id2, std::shared_ptr<Body> b2,
+            const Vec2D &anchor1, const Vec2D &anchor2
+            ): Joint(id1, std::move(b1), id2, std::move(b2), anchor1, anchor2) {
+        length = Vec2D::distance(anchor1, anchor2);
+    }
+
+    real DistanceJoint::get_length() const {
+        return length;
+    }
+
+    void DistanceJoint::set_length(real l) {
+        if (l < 0) {throw SimulationException("The length of a distance joint must be >= 0");}
+        length = l;
+    }
+
+
+    void DistanceJoint::prepare(const BodyStorage &bodies, real delta_t) {
+        prepare_anchors(bodies);
+
+        Vec2D d = anchors_distance(bodies);
+        real current_length = d.norm();
+
+        // With both anchors at the same place, any direction will do
+        axis = current_length > 0 ? d / current_length : Vec2D(1, 0);
+
+        real arm1_cross = Vec2D::cross(arm1, axis);
+        real arm2_cross = Vec2D::cross(arm2, axis);
+        real inv_mass = bodies.inv_masses[index1] + bodies.inv_masses[index2]
+                + bodies.inv_inertias[index1] * arm1_cross * arm1_cross
+                + bodies.inv_inertias[index2] * arm2_cross * arm2_cross;
+        mass = inv_mass > 0 ? 1 / inv_mass : 0;
+
+        bias = (current_length - length) * POSITION_CORRECTION / delta_t;
+    }
+
+    void DistanceJoint::warm_start(BodyStorage &bodies) {
+        apply_impulse(bodies, axis * impulse);
+    }
+
+    void DistanceJoint::solve_velocity(BodyStorage &bodies) {
+        real velocity = Vec2D::dot(relative_velocity(bodies), axis);
+        real lambda = -mass * (velocity + bias);
+        impulse += lambda;
+        apply_impulse(bodies, axis * lambda);
+    }
+} // Msfl2D
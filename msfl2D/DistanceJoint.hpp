@@ -0,0 +1,59 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#ifndef MSFL2D_DISTANCEJOINT_HPP
+#define MSFL2D_DISTANCEJOINT_HPP
+
+#include "Joint.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * Joint keeping its 2 anchors at a fixed distance from each other, like a rigid rod with a free hinge at each end.
+     * Created with World::add_distance_joint().
+     */
+    class DistanceJoint: public Joint {
+    public:
+        /**
+         * Return the distance kept between the anchors.
+         */
+        real get_length() const;
+
+        /**
+         * Set the distance kept between the anchors.
+         * Throws SimulationException if the value is negative.
+         */
+        void set_length(real l);
+
+    protected:
+        friend class World;
+
+        /**
+         * Create a distance joint between the 2 bodies. The anchors are given in world-space coordinates, and the
+         * distance between them becomes the length of the joint.
+         */
+        DistanceJoint(
+                BodyID id1, std::shared_ptr<Body> b1,
+                BodyID id2, std::shared_ptr<Body> b2,
+                const Vec2D& anchor1, const Vec2D& anchor2
+                );
+
+        void prepare(const BodyStorage& bodies, real delta_t) override;
+        void warm_start(BodyStorage& bodies) override;
+        void solve_velocity(BodyStorage& bodies) override;
+
+    private:
+        real length;
+
+        // Direction from anchor 1 to anchor 2, effective mass & bias of the constraint. Computed by prepare().
+        Vec2D axis;
+        real mass = 0;
+        real bias = 0;
+
+        real impulse = 0;
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_DISTANCEJOINT_HPP
@@ -0,0 +1,94 @@
+//
+// Created by myselfleo on 23/07/2023.
+//
+
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Msfl2D {
+    FrameArena::FrameArena(std::size_t initial_size, std::shared_ptr<MemoryCounter> counter):
+        blocks(CountingAllocator<Block>(counter)),
+        counter(std::move(counter))
+        {
+        add_block(initial_size > 0 ? initial_size : 1);
+    }
+
+    FrameArena::~FrameArena() {
+        if (counter != nullptr) {counter->remove(get_capacity());}
+    }
+
+    FrameArena::FrameArena(FrameArena &&other) noexcept:
+        blocks(std::move(other.blocks)),
+        current(other.current),
+        offset(other.offset),
+        used(other.used),
+        counter(std::move(other.counter))
+        {
+        other.blocks.clear();
+    }
+
+    FrameArena &FrameArena::operator=(FrameArena &&other) noexcept {
+        if (this == &other) {return *this;}
+        if (counter != nullptr) {counter->remove(get_capacity());}
+
+        blocks = std::move(other.blocks);
+        other.blocks.clear();
+        current = other.current;
+        offset = other.offset;
+        used = other.used;
+        counter = std::move(other.counter);
+        return *this;
+    }
+
+    void* FrameArena::allocate(std::size_t size, std::size_t alignment) {
+        while (true) {
+            Block& block = blocks[current];
+            auto address = reinterpret_cast<std::uintptr_t>(block.data.get()) + offset;
+            std::size_t padding = (alignment - address % alignment) % alignment;
+
+            if (offset + padding + size <= block.size) {
+                offset += padding + size;
+                used += padding + size;
+                return block.data.get() + offset - size;
+            }
+
+            // The rest of the block is lost until the next reset
+            if (current + 1 == blocks.size()) {add_block(size + alignment);}
+            current++;
+            offset = 0;
+        }
+    }
+
+    void FrameArena::reset() {
+        // Replace the blocks by a single one, large enough for a step like this one
+        if (blocks.size() > 1) {
+            std::size_t capacity = get_capacity();
+            if (counter != nullptr) {counter->remove(capacity);}
+            blocks.clear();
+            add_block(capacity);
+        }
+
+        current = 0;
+        offset = 0;
+        used = 0;
+    }
+
+    std::size_t FrameArena::get_used() const {
+        return used;
+    }
+
+    std::size_t FrameArena::get_capacity() const {
+        std::size_t capacity = 0;
+        for (auto& b: blocks) {capacity += b.size;}
+        return capacity;
+    }
+
+    void FrameArena::add_block(std::size_t min_size) {
+        // Each block is at least as large as the previous one, so a growing step needs few blocks
+        std::size_t size = blocks.empty() ? min_size : std::max(min_size, blocks.back().size);
+        blocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+        if (counter != nullptr) {counter->add(size);}
+    }
+} // Msfl2D
@@ -0,0 +1,122 @@
+//
+// Created by myselfleo on 23/07/2023.
+//
+
+#ifndef MSFL2D_FRAMEARENA_HPP
+#define MSFL2D_FRAMEARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "MemoryStats.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * Bump allocator for the data living during a single update step (pairs, islands, etc.).
+     *
+     * Allocating only moves an offset forward in a block of memory, and nothing is freed until reset(), which makes
+     * the whole memory available again at once. When a step needs more memory than the arena holds, new blocks are
+     * added; they are merged into a single block at the next reset, so once warm, the arena doesn't allocate anymore.
+     */
+    class FrameArena {
+    public:
+        /**
+         * Create an arena with a first block of the given size, in bytes.
+         * The memory of the blocks is counted in the given counter if it is not null.
+         */
+        explicit FrameArena(std::size_t initial_size = 64 * 1024, std::shared_ptr<MemoryCounter> counter = nullptr);
+
+        ~FrameArena();
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+        FrameArena(FrameArena&& other) noexcept;
+        FrameArena& operator=(FrameArena&& other) noexcept;
+
+        /**
+         * Return a block of memory of the given size & alignment, valid until the next reset.
+         */
+        void* allocate(std::size_t size, std::size_t alignment);
+
+        /**
+         * Release everything allocated since the last reset.
+         */
+        void reset();
+
+        /**
+         * Return the number of bytes allocated since the last reset, alignment padding included.
+         */
+        std::size_t get_used() const;
+
+        /**
+         * Return the total size of the blocks of the arena, in bytes.
+         */
+        std::size_t get_capacity() const;
+
+    private:
+        struct Block {
+            std::unique_ptr<unsigned char[]> data;
+            std::size_t size;
+        };
+
+        CountedVector<Block> blocks;
+
+        // Block currently used, and offset of its first free byte
+        std::size_t current = 0;
+        std::size_t offset = 0;
+
+        std::size_t used = 0;
+
+        std::shared_ptr<MemoryCounter> counter;
+
+        /**
+         * Add a block of at least the given size at the end of the arena.
+         */
+        void add_block(std::size_t min_size);
+    };
+
+
+    /**
+     * Standard allocator allocating from a FrameArena. Deallocating does nothing: the memory is released when the
+     * arena is reset, so the containers using it must not be used after that.
+     */
+    template<typename T>
+    class ArenaAllocator {
+    public:
+        typedef T value_type;
+
+        explicit ArenaAllocator(FrameArena& arena): arena(&arena) {}
+
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other): arena(other.arena) {} // NOLINT(google-explicit-constructor)
+
+        T* allocate(std::size_t n) {
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T*, std::size_t) {}
+
+        template<typename U>
+        bool operator==(const ArenaAllocator<U>& other) const {return arena == other.arena;}
+
+        template<typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const {return arena != other.arena;}
+
+    private:
+        template<typename U> friend class ArenaAllocator;
+
+        FrameArena* arena;
+    };
+
+
+    /**
+     * Vector allocated in a FrameArena.
+     */
+    template<typename T>
+    using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+} // Msfl2D
+
+#endif //MSFL2D_FRAMEARENA_HPP
@@ -0,0 +1,25 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#include "Island.hpp"
+
+namespace Msfl2D {
+    Island::Island(FrameArena &arena):
+        contacts(ArenaAllocator<ContactConstraint*>(arena)),
+        joints(ArenaAllocator<Joint*>(arena))
+        {}
+
+    void Island::solve_velocities(BodyStorage &bodies, real delta_t, int iterations) {
+        for (auto c: contacts) {CollisionResolver::prepare(bodies, *c, delta_t);}
+        for (auto j: joints) {j->prepare(bodies, delta_t);}
+
+        for (auto c: contacts) {CollisionResolver::warm_start(bodies, *c);}
+        for (auto j: joints) {j->warm_start(bodies);}
+
+        for (int it=0; it<iterations; it++) {
+            for (auto j: joints) {j->solve_velocity(bodies);}
+            for (auto c: contacts) {CollisionResolver::solve_velocity(bodies, *c);}
+        }
+    }
+} // Msfl2D
@@ -0,0 +1,40 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#ifndef MSFL2D_ISLAND_HPP
+#define MSFL2D_ISLAND_HPP
+
+#include "CollisionResolver.hpp"
+#include "Joint.hpp"
+#include "FrameArena.hpp"
+
+#include <vector>
+
+namespace Msfl2D {
+
+    /**
+     * Group of bodies interacting with each other through contacts or joints. Each island can be solved independently
+     * from the others. Static & kinematic bodies don't link islands together, as the solver can't move them.
+     * Islands are built by the World at each update step, in its frame arena.
+     */
+    class Island {
+    public:
+        FrameVector<ContactConstraint*> contacts;
+        FrameVector<Joint*> joints;
+
+        /**
+         * Create an empty island, whose lists are allocated in the given arena.
+         */
+        explicit Island(FrameArena& arena);
+
+        /**
+         * Solve the velocities of the bodies of the island: the contacts & joints are prepared, the impulses of the
+         * last step are applied (warm starting), then each constraint is solved once per iteration.
+         */
+        void solve_velocities(BodyStorage& bodies, real delta_t, int iterations);
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_ISLAND_HPP
@@ -0,0 +1,257 @@
+//
+// Created by myselfleo on 28/07/2023.
+//
+
+#include "JobSystem.hpp"
+#include "MsflExceptions.hpp"
+
+#include <algorithm>
+
+namespace Msfl2D {
+    namespace {
+        /**
+         * JobSystem of which the current thread is a worker, and index of its queue.
+         */
+        struct WorkerIdentity {
+            const JobSystem* system = nullptr;
+            std::size_t queue_index = 0;
+        };
+
+        thread_local WorkerIdentity current_worker;
+    }
+
+
+    JobSystem::JobSystem(int nb_threads) {
+        if (nb_threads < 0) {throw SimulationException("The number of threads of a JobSystem must be >= 0");}
+        if (nb_threads == 0) {nb_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));}
+        concurrency = nb_threads;
+
+        for (int i=0; i<nb_threads; i++) {queues.push_back(std::make_unique<JobQueue>());}
+
+        // The waiting thread is the last one, so nb_threads - 1 workers are enough
+        for (int i=0; i<nb_threads - 1; i++) {
+            workers.emplace_back(&JobSystem::work, this, i);
+        }
+    }
+
+    JobSystem::JobSystem(Executor executor, int concurrency):
+        concurrency(concurrency),
+        executor(std::move(executor))
+        {
+        if (!this->executor) {throw SimulationException("The executor of a JobSystem can't be empty");}
+        if (concurrency < 1) {throw SimulationException("The concurrency of a JobSystem must be >= 1");}
+
+        // Every thread uses the shared queue
+        queues.push_back(std::make_unique<JobQueue>());
+    }
+
+    JobSystem::~JobSystem() {
+        // Run what's left, so the tasks submitted but never waited for are done anyway
+        while (run_one()) {}
+
+        running = false;
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            wake_up.notify_all();
+        }
+        for (auto& w: workers) {w.join();}
+
+        while (nb_executor_calls.load() > 0) {std::this_thread::yield();}
+    }
+
+
+    int JobSystem::get_concurrency() const {
+        return concurrency;
+    }
+
+
+    std::shared_ptr<JobSystem::Task> JobSystem::submit(
+            std::function<void()> function,
+            const std::vector<std::shared_ptr<Task>> &dependencies
+            ) {
+        auto task = std::make_shared<Task>();
+        task->function = std::move(function);
+
+        for (auto& d: dependencies) {
+            std::lock_guard<std::mutex> lock(d->mutex);
+            if (d->done) {continue;}
+            task->nb_pending_dependencies++;
+            d->dependents.push_back(task);
+        }
+
+        // Remove the count preventing the task from being scheduled while the dependencies were registered
+        if (task->nb_pending_dependencies.fetch_sub(1) == 1) {schedule(task);}
+        return task;
+    }
+
+    void JobSystem::wait(const std::shared_ptr<Task> &task) {
+        while (!task->is_done()) {
+            if (!run_one()) {std::this_thread::yield();}
+        }
+
+        if (task->exception) {std::rethrow_exception(task->exception);}
+    }
+
+
+    int JobSystem::get_grain(int size, int min_grain) const {
+        // With a single thread, splitting the range would only add overhead
+        if (concurrency == 1) {return size;}
+
+        int nb_chunks = concurrency * 8;
+        return std::max({(size + nb_chunks - 1) / nb_chunks, min_grain, 1});
+    }
+
+    void JobSystem::run_range(RangeState &state, int begin, int end) {
+        state.pending = 1;
+        run_chunk(*this, &state, begin, end);
+
+        while (state.pending.load(std::memory_order_acquire) > 0) {
+            if (!run_one()) {std::this_thread::yield();}
+        }
+
+        if (state.exception) {std::rethrow_exception(state.exception);}
+    }
+
+    void JobSystem::run_chunk(JobSystem &system, void *context, int begin, int end) {
+        auto& state = *static_cast<RangeState*>(context);
+
+        // Push the second half of the range until the rest is small enough; idle threads steal the largest halves
+        // first, as they are the oldest jobs of the queue.
+        while (end - begin > state.grain) {
+            int middle = begin + (end - begin) / 2;
+            state.pending++;
+            system.push({&JobSystem::run_chunk, &state, middle, end});
+            end = middle;
+        }
+
+        if (!state.failed.load(std::memory_order_relaxed)) {
+            try {state.call(state.function, begin, end);}
+            catch (...) {
+                if (!state.failed.exchange(true)) {state.exception = std::current_exception();}
+            }
+        }
+
+        state.pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    void JobSystem::run_task(JobSystem &system, void *context, int, int) {
+        // Take the reference held by the queue
+        std::shared_ptr<Task> task = std::move(static_cast<Task*>(context)->self);
+
+        try {task->function();}
+        catch (...) {task->exception = std::current_exception();}
+        task->function = nullptr;
+
+        std::vector<std::shared_ptr<Task>> dependents;
+        {
+            std::lock_guard<std::mutex> lock(task->mutex);
+            task->done.store(true, std::memory_order_release);
+            std::swap(dependents, task->dependents);
+        }
+
+        for (auto& d: dependents) {
+            if (d->nb_pending_dependencies.fetch_sub(1) == 1) {system.schedule(d);}
+        }
+    }
+
+
+    void JobSystem::push(const Job &job) {
+        queues[get_queue_index()]->push(job);
+        nb_queued_jobs++;
+
+        if (executor) {
+            nb_executor_calls++;
+            executor([this]() {
+                run_one();
+                nb_executor_calls--;
+            });
+        }
+        else if (nb_sleeping.load() > 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            wake_up.notify_one();
+        }
+    }
+
+    bool JobSystem::run_one() {
+        if (nb_queued_jobs.load() == 0) {return false;}
+
+        std::size_t index = get_queue_index();
+        Job job{};
+        bool found = queues[index]->pop_back(job);
+        for (std::size_t i=1; !found && i<queues.size(); i++) {
+            found = queues[(index + i) % queues.size()]->pop_front(job);
+        }
+        if (!found) {return false;}
+
+        nb_queued_jobs--;
+        job.run(*this, job.context, job.begin, job.end);
+        return true;
+    }
+
+    void JobSystem::schedule(const std::shared_ptr<Task> &task) {
+        task->self = task;
+        push({&JobSystem::run_task, task.get(), 0, 0});
+    }
+
+    std::size_t JobSystem::get_queue_index() const {
+        if (current_worker.system == this) {return current_worker.queue_index;}
+        return queues.size() - 1;
+    }
+
+    void JobSystem::work(std::size_t index) {
+        current_worker = {this, index};
+
+        while (true) {
+            if (run_one()) {continue;}
+
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            nb_sleeping++;
+            wake_up.wait(lock, [this]() {return nb_queued_jobs.load() > 0 || !running.load();});
+            nb_sleeping--;
+
+            if (!running.load() && nb_queued_jobs.load() == 0) {return;}
+        }
+    }
+
+
+    void JobSystem::JobQueue::push(const Job &job) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Drop the jobs stolen at the front when they take most of the memory
+        if (front > 64 && front * 2 > jobs.size()) {
+            jobs.erase(jobs.begin(), jobs.begin() + front);
+            front = 0;
+        }
+        jobs.push_back(job);
+    }
+
+    bool JobSystem::JobQueue::pop_back(Job &job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.size() == front) {return false;}
+
+        job = jobs.back();
+        jobs.pop_back();
+        if (jobs.size() == front) {
+            jobs.clear();
+            front = 0;
+        }
+        return true;
+    }
+
+    bool JobSystem::JobQueue::pop_front(Job &job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.size() == front) {return false;}
+
+        job = jobs[front++];
+        if (jobs.size() == front) {
+            jobs.clear();
+            front = 0;
+        }
+        return true;
+    }
+
+
+    bool JobSystem::Task::is_done() const {
+        return done.load(std::memory_order_acquire);
+    }
+} // Msfl2D
@@ -0,0 +1,261 @@
+//
+// Created by myselfleo on 28/07/2023.
+//
+
+#ifndef MSFL2D_JOBSYSTEM_HPP
+#define MSFL2D_JOBSYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Msfl2D {
+
+    /**
+     * Work-stealing scheduler running the parallel parts of the simulation.
+     *
+     * Each worker thread has its own queue of jobs: it runs the last job it pushed (which is likely to be in its
+     * cache), and when its queue is empty, it steals the oldest job of another queue. The threads which are not
+     * workers push their jobs to a shared queue. A thread waiting for jobs to finish runs jobs in the meantime, so
+     * parallel loops & tasks can be nested, and the calling thread always takes part in the work.
+     *
+     * Instead of its own threads, a JobSystem can use an executor provided by the host application: it is given a
+     * function to run for each job pushed, which runs one of the pending jobs.
+     *
+     * A JobSystem can be shared by several Worlds, and used from several threads at once.
+     */
+    class JobSystem {
+    public:
+        /**
+         * Function running a function given by the JobSystem, on any thread, at any time. The JobSystem must
+         * outlive the functions it gives to the executor: its destructor waits until they have all returned.
+         */
+        typedef std::function<void(std::function<void()>)> Executor;
+
+        /**
+         * Task scheduled by submit(), which may be the dependency of other tasks.
+         */
+        class Task;
+
+        /**
+         * Create a JobSystem running the jobs on the given number of threads, the thread waiting for the jobs
+         * included (so 1 creates no thread, and everything is run by the caller). 0 means one thread per core.
+         * Throws SimulationException if the number of threads is negative.
+         */
+        explicit JobSystem(int nb_threads = 0);
+
+        /**
+         * Create a JobSystem running the jobs through the given executor, which is expected to run about
+         * `concurrency` functions at once. The JobSystem creates no thread.
+         * Throws SimulationException if the executor is empty or if concurrency is < 1.
+         */
+        JobSystem(Executor executor, int concurrency);
+
+        /**
+         * Wait for the pending jobs to be done, and stop the threads.
+         */
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        /**
+         * Return the number of jobs that may run at the same time.
+         */
+        int get_concurrency() const;
+
+        /**
+         * Schedule a task, run once each of its dependencies is done.
+         */
+        std::shared_ptr<Task> submit(std::function<void()> function, const std::vector<std::shared_ptr<Task>>& dependencies = {});
+
+        /**
+         * Wait for the task to be done, running other jobs in the meantime. If the task threw an exception, it is
+         * thrown again.
+         */
+        void wait(const std::shared_ptr<Task>& task);
+
+        /**
+         * Call function(first, last) over consecutive sub-ranges of [begin, end[, in parallel, and return once
+         * the whole range is done. The range is split into chunks of at least min_grain indices; the chunks get
+         * larger when the range is large compared to the number of threads, so there are about 8 chunks per thread.
+         * If the function throws, the first exception is thrown again once every chunk is done.
+         */
+        template<typename F>
+        void parallel_for(int begin, int end, int min_grain, const F& function) {
+            if (end <= begin) {return;}
+
+            run_chunks(begin, end, get_grain(end - begin, min_grain), function);
+        }
+
+        /**
+         * Call function(index) for each index of [begin, end[, in parallel, each index being a job of its own
+         * whatever the size of the range, and return once they are all done. Meant for few, long and uneven
+         * iterations, which parallel_for would group in chunks running one after the other on the same thread.
+         * If the function throws, the first exception is thrown again once every index is done.
+         */
+        template<typename F>
+        void parallel_for_each(int begin, int end, const F& function) {
+            if (end <= begin) {return;}
+
+            auto call_range = [&function](int first, int last) {
+                for (int i=first; i<last; i++) {function(i);}
+            };
+            run_chunks(begin, end, concurrency == 1 ? end - begin : 1, call_range);
+        }
+
+    private:
+        /**
+         * Unit of work stored in the queues: a function called with a context & a range.
+         */
+        struct Job {
+            void (*run)(JobSystem& system, void* context, int begin, int end);
+            void* context;
+            int begin;
+            int end;
+        };
+
+        /**
+         * Double-ended queue of jobs: its owner pushes & pops at the back, the other threads steal at the front.
+         * The memory of the jobs is reused, so pushing doesn't allocate once warm.
+         */
+        struct JobQueue {
+            std::mutex mutex;
+            std::vector<Job> jobs;
+            std::size_t front = 0;
+
+            void push(const Job& job);
+            bool pop_back(Job& job);
+            bool pop_front(Job& job);
+        };
+
+        /**
+         * Shared state of the chunks of a parallel_for.
+         */
+        struct RangeState {
+            const void* function;
+            void (*call)(const void* function, int first, int last);
+            int grain;
+            // Chunks pushed but not done yet
+            std::atomic<int> pending{0};
+            std::atomic<bool> failed{false};
+            std::exception_ptr exception;
+        };
+
+        int concurrency;
+        Executor executor;
+
+        // One queue per worker, followed by the queue shared by the other threads
+        std::vector<std::unique_ptr<JobQueue>> queues;
+        std::vector<std::thread> workers;
+
+        std::atomic<int> nb_queued_jobs{0};
+        std::atomic<bool> running{true};
+
+        // Sleeping workers wait for jobs on the condition variable
+        std::mutex sleep_mutex;
+        std::condition_variable wake_up;
+        std::atomic<int> nb_sleeping{0};
+
+        // Functions given to the executor which haven't returned yet
+        std::atomic<int> nb_executor_calls{0};
+
+        /**
+         * Call function(first, last) over the chunks of `grain` indices of [begin, end[, in parallel.
+         */
+        template<typename F>
+        void run_chunks(int begin, int end, int grain, const F& function) {
+            if (end - begin <= grain) {
+                function(begin, end);
+                return;
+            }
+
+            RangeState state;
+            state.function = &function;
+            state.call = [](const void* f, int first, int last) {(*static_cast<const F*>(f))(first, last);};
+            state.grain = grain;
+            run_range(state, begin, end);
+        }
+
+        /**
+         * Return the size of the chunks of a parallel_for over the given number of indices.
+         */
+        int get_grain(int size, int min_grain) const;
+
+        /**
+         * Split a range in chunks, pushing all of them but one to the queue of the current thread, run the
+         * remaining one, and wait for the others.
+         */
+        void run_range(RangeState& state, int begin, int end);
+
+        /**
+         * Job of a parallel_for chunk: split it further if it is too large, then run it.
+         */
+        static void run_chunk(JobSystem& system, void* context, int begin, int end);
+
+        /**
+         * Job of a task submitted with submit().
+         */
+        static void run_task(JobSystem& system, void* context, int begin, int end);
+
+        /**
+         * Push a job to the queue of the current thread.
+         */
+        void push(const Job& job);
+
+        /**
+         * Run a job of the queue of the current thread, or one stolen from another queue.
+         * Return false if no job was found.
+         */
+        bool run_one();
+
+        /**
+         * Push a task to a queue, once its dependencies are done.
+         */
+        void schedule(const std::shared_ptr<Task>& task);
+
+        /**
+         * Return the index of the queue of the current thread.
+         */
+        std::size_t get_queue_index() const;
+
+        /**
+         * Main loop of a worker thread.
+         */
+        void work(std::size_t index);
+    };
+
+
+    class JobSystem::Task {
+    public:
+        /**
+         * Return whether the task is done.
+         */
+        bool is_done() const;
+
+    private:
+        friend class JobSystem;
+
+        std::function<void()> function;
+        std::exception_ptr exception;
+
+        // Dependencies not done yet, plus 1 until the task is fully submitted
+        std::atomic<int> nb_pending_dependencies{1};
+
+        // Tasks depending on this one, scheduled once it is done
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Task>> dependents;
+        std::atomic<bool> done{false};
+
+        // Reference keeping the task alive while it is in a queue
+        std::shared_ptr<Task> self;
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_JOBSYSTEM_HPP
@@ -0,0 +1,97 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#include <cmath>
+#include <utility>
+
+#include "Joint.hpp"
+
+namespace Msfl2D {
+    Joint::Joint(
+            BodyID id1, std::shared_ptr<Body> b1,
+            BodyID id2, std::shared_ptr<Body> b2,
+            const Vec2D &anchor1, const Vec2D &anchor2
+            ):
+        body1(std::move(b1)),
+        body2(std::move(b2)),
+        body1_id(id1),
+        body2_id(id2)
+        {
+        // Remove the current position & rotation of the bodies from the anchors
+        Transform2D transform1 = body1->get_transform();
+        Transform2D transform2 = body2->get_transform();
+        local_anchor1 = transform1.apply_inverse(anchor1);
+        local_anchor2 = transform2.apply_inverse(anchor2);
+        reference_rotation = transform2.rotation * transform1.rotation.inverse();
+    }
+
+    std::shared_ptr<Body> Joint::get_body1() const {return body1;}
+    std::shared_ptr<Body> Joint::get_body2() const {return body2;}
+
+    BodyID Joint::get_body1_id() const {return body1_id;}
+    BodyID Joint::get_body2_id() const {return body2_id;}
+
+    Vec2D Joint::get_anchor1() const {
+        return body1->get_transform().apply(local_anchor1);
+    }
+
+    Vec2D Joint::get_anchor2() const {
+        return body2->get_transform().apply(local_anchor2);
+    }
+
+
+    void Joint::prepare_anchors(const BodyStorage &bodies) {
+        index1 = body1->index;
+        index2 = body2->index;
+        arm1 = bodies.rotations[index1].rotate(local_anchor1);
+        arm2 = bodies.rotations[index2].rotate(local_anchor2);
+    }
+
+    Vec2D Joint::anchors_distance(const BodyStorage &bodies) const {
+        return (bodies.positions[index2] + arm2) - (bodies.positions[index1] + arm1);
+    }
+
+
+    void Joint::apply_impulse(BodyStorage &bodies, const Vec2D &impulse) const {
+        // The inverses of the mass & inertia are 0 for static & kinematic bodies, so they won't be affected.
+        bodies.velocities[index1] -= impulse * bodies.inv_masses[index1];
+        bodies.angular_velocities[index1] -= Vec2D::cross(arm1, impulse) * bodies.inv_inertias[index1];
+        bodies.velocities[index2] += impulse * bodies.inv_masses[index2];
+        bodies.angular_velocities[index2] += Vec2D::cross(arm2, impulse) * bodies.inv_inertias[index2];
+    }
+
+    void Joint::apply_angular_impulse(BodyStorage &bodies, real impulse) const {
+        bodies.angular_velocities[index1] -= impulse * bodies.inv_inertias[index1];
+        bodies.angular_velocities[index2] += impulse * bodies.inv_inertias[index2];
+    }
+
+    Vec2D Joint::relative_velocity(const BodyStorage &bodies) const {
+        Vec2D v1 = bodies.velocities[index1] + Vec2D::cross(bodies.angular_velocities[index1], arm1);
+        Vec2D v2 = bodies.velocities[index2] + Vec2D::cross(bodies.angular_velocities[index2], arm2);
+        return v2 - v1;
+    }
+
+    real Joint::relative_rotation(const BodyStorage &bodies) const {
+        // Composing the rotors gives the difference of the angles, already in [-pi, pi]
+        return (bodies.rotations[index2] * bodies.rotations[index1].inverse() * reference_rotation.inverse()).angle();
+    }
+
+
+    void Joint::prepare_angle(const BodyStorage &bodies, real delta_t) {
+        real inv_inertia_sum = bodies.inv_inertias[index1] + bodies.inv_inertias[index2];
+        angular_mass = inv_inertia_sum > 0 ? 1 / inv_inertia_sum : 0;
+        angular_bias = relative_rotation(bodies) * POSITION_CORRECTION / delta_t;
+    }
+
+    void Joint::warm_start_angle(BodyStorage &bodies) const {
+        apply_angular_impulse(bodies, angular_impulse);
+    }
+
+    void Joint::solve_angle(BodyStorage &bodies) {
+        real relative_angular_vel = bodies.angular_velocities[index2] - bodies.angular_velocities[index1];
+        real impulse = -angular_mass * (relative_angular_vel + angular_bias);
+        angular_impulse += impulse;
+        apply_angular_impulse(bodies, impulse);
+    }
+} // Msfl2D
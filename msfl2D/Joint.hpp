@@ -0,0 +1,157 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#ifndef MSFL2D_JOINT_HPP
+#define MSFL2D_JOINT_HPP
+
+#include "Body.hpp"
+#include "BodyStorage.hpp"
+
+#include <memory>
+
+namespace Msfl2D {
+
+    typedef unsigned long JointID;
+
+    /**
+     * Base class for the joints, i.e. constraints connecting 2 bodies (like a rod, a hinge or a rail).
+     * Joints are created & destroyed through the World, which solves them along with the contacts.
+     *
+     * The anchors of a joint are points attached to each of its bodies. They are stored relative to the body centers,
+     * without the body rotations, so they follow the bodies when they move or rotate.
+     *
+     * Derived joints must implement prepare(), warm_start() and solve_velocity(), which are called by the solver
+     * at each update step. The impulses computed during a step are kept by the joint, and applied again at the
+     * beginning of the next one (warm starting), so the solver doesn't start from scratch.
+     */
+    class Joint {
+    public:
+        /**
+         * Proportion of the position error of a joint corrected at each step.
+         */
+        static constexpr real POSITION_CORRECTION = 0.2;
+
+        virtual ~Joint() = default;
+
+        std::shared_ptr<Body> get_body1() const;
+        std::shared_ptr<Body> get_body2() const;
+
+        BodyID get_body1_id() const;
+        BodyID get_body2_id() const;
+
+        /**
+         * Return the position of the anchor attached to the first body, in world-space coordinates.
+         */
+        Vec2D get_anchor1() const;
+
+        /**
+         * Return the position of the anchor attached to the second body, in world-space coordinates.
+         */
+        Vec2D get_anchor2() const;
+
+    protected:
+        friend class World;
+        friend class Island;
+
+        std::shared_ptr<Body> body1;
+        std::shared_ptr<Body> body2;
+        BodyID body1_id;
+        BodyID body2_id;
+
+        // Anchors, relative to the body centers & without the body rotations
+        Vec2D local_anchor1;
+        Vec2D local_anchor2;
+
+        // Rotation of body2 relative to body1 when the joint was created
+        Rotor2D reference_rotation;
+
+        // Rows of the bodies in the storage of the World, and anchors relative to the body centers, in world-space.
+        // Computed by prepare_anchors().
+        int index1 = 0;
+        int index2 = 0;
+        Vec2D arm1;
+        Vec2D arm2;
+
+        // Values of the angular constraint (see prepare_angle()), for the joints that need one
+        real angular_mass = 0;
+        real angular_bias = 0;
+        real angular_impulse = 0;
+
+
+        /**
+         * Create a joint between the 2 bodies. The anchors are given in world-space coordinates.
+         */
+        Joint(
+                BodyID id1, std::shared_ptr<Body> b1,
+                BodyID id2, std::shared_ptr<Body> b2,
+                const Vec2D& anchor1, const Vec2D& anchor2
+                );
+
+        /**
+         * Compute the values used by the solver which are constant during the step, like the position of the
+         * anchors, the effective masses, or the position error to correct.
+         */
+        virtual void prepare(const BodyStorage& bodies, real delta_t) = 0;
+
+        /**
+         * Apply the impulses accumulated during the last step.
+         */
+        virtual void warm_start(BodyStorage& bodies) = 0;
+
+        /**
+         * Compute & apply the impulse correcting the relative velocity of the bodies. Called once per solver iteration.
+         */
+        virtual void solve_velocity(BodyStorage& bodies) = 0;
+
+
+        /**
+         * Find the rows of the bodies, and compute the position of the anchors relative to the body centers.
+         */
+        void prepare_anchors(const BodyStorage& bodies);
+
+        /**
+         * Return the vector from anchor 1 to anchor 2. The anchors must be prepared.
+         */
+        Vec2D anchors_distance(const BodyStorage& bodies) const;
+
+
+        /**
+         * Apply an angular impulse to body2, and the opposite angular impulse to body1.
+         */
+        void apply_angular_impulse(BodyStorage& bodies, real impulse) const;
+
+        /**
+         * Apply the impulse to body2 at its anchor, and the opposite impulse to body1 at its anchor.
+         */
+        void apply_impulse(BodyStorage& bodies, const Vec2D& impulse) const;
+
+        /**
+         * Return the velocity of the anchor of body2 relative to the anchor of body1.
+         */
+        Vec2D relative_velocity(const BodyStorage& bodies) const;
+
+        /**
+         * Return the rotation of body2 relative to body1, minus the reference angle, in [-pi, pi].
+         */
+        real relative_rotation(const BodyStorage& bodies) const;
+
+        /**
+         * Compute the values of the angular constraint, which keeps the bodies from rotating relative to each other.
+         */
+        void prepare_angle(const BodyStorage& bodies, real delta_t);
+
+        /**
+         * Apply the angular impulse of the last step.
+         */
+        void warm_start_angle(BodyStorage& bodies) const;
+
+        /**
+         * Compute & apply the angular impulse of the angular constraint.
+         */
+        void solve_angle(BodyStorage& bodies);
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_JOINT_HPP
@@ -25,18 +25,18 @@ namespace Msfl2D {
 
     LineSide Line::side(const Vec2D &p1, const Vec2D &p2, const Vec2D &p) {
         // cross product of (p2-p1, p-p1)
-        double orient = (p2.x - p1.x) * (p.y - p1.y) - (p2.y - p1.y) * (p.x - p1.x);
+        real orient = (p2.x - p1.x) * (p.y - p1.y) - (p2.y - p1.y) * (p.x - p1.x);
         if (orient > 0) {return LEFT;}
         if (orient < 0) {return RIGHT;}
         return MIDDLE;
     }
 
-    double Line::find_y(double x) const {
+    real Line::find_y(real x) const {
         if (is_vertical()) {throw GeometryException("Infinite number of solutions for y = ? in a vertical line.");}
         return get_slope() * x + get_zero();
     }
 
-    double Line::find_x(double y) const {
+    real Line::find_x(real y) const {
         if (is_vertical()) {return p1.x;}
         if (p1.y == p2.y) {throw GeometryException("Infinite number of solutions for x = ? in an horizontal line.");}
         return (y - get_zero()) / get_slope();
@@ -50,12 +50,12 @@ namespace Msfl2D {
         return (p2 - p1).normalized();
     }
 
-    double Line::get_slope() const {
+    real Line::get_slope() const {
         if (is_vertical()) {throw GeometryException("No slope for a vertical line.");}
         return (p2.y - p1.y) / (p2.x - p1.x);
     }
 
-    double Line::get_zero() const {
+    real Line::get_zero() const {
         return p1.y - get_slope() * p1.x;
     }
 
@@ -63,7 +63,7 @@ namespace Msfl2D {
         return p1;
     }
 
-    Vec2D Line::get_coo_grad(double g) const {
+    Vec2D Line::get_coo_grad(real g) const {
         return get_origin() + get_vec() * g;
     }
 
@@ -99,7 +99,7 @@ namespace Msfl2D {
         else {return find_y(p.x) == p.y;}
     }
 
-    double Line::get_grad_coo(const Vec2D &p) const {
+    real Line::get_grad_coo(const Vec2D &p) const {
         // we need to find n such as v1 = v2.n
         // where v2 is the dir vec of the line (normalised, so its length is 1 graduation)
         // & v1 is the vector from the line origin to the given point.
@@ -109,8 +109,8 @@ namespace Msfl2D {
         // todo: fix that s
 
         // If ratio_x != ratio_y, the given point is not on the line.
-        double ratio_x = v1.x / v2.x;
-        /*double ratio_y = v1.y / v2.y;
+        real ratio_x = v1.x / v2.x;
+        /*real ratio_y = v1.y / v2.y;
 
         if (ratio_x != ratio_y) {throw GeometryException("The point given to get_grad_coo() is not on the line.");}
         return ratio_x;*/
@@ -57,12 +57,12 @@ namespace Msfl2D {
         /**
          * Return the y coordinate of the point of the line at the x coordinate
          */
-        double find_y(double x) const;
+        real find_y(real x) const;
 
         /**
          * Return the x coordinate of the point of the line at the y coordinate
          */
-        double find_x(double y) const;
+        real find_x(real y) const;
 
         /**
          * Return true if the line is perpendicular to the x axis.
@@ -77,14 +77,14 @@ namespace Msfl2D {
         /**
          * Return the slope of the line. This is the 'a' in the equation y = ax + b
          */
-        double get_slope() const;
+        real get_slope() const;
 
         /**
          * Return the y value for x = 0. This is the 'b' in the equation y = ax + b.
          * Don't confuse this function with get_origin(), which return the coordinates of the point on the line
          * where the graduation along the line is starting.
          */
-        double get_zero() const;
+        real get_zero() const;
 
         /**
          * Return the coordinates of the line's origin in the global space. This is the origin of the graduation
@@ -98,7 +98,7 @@ namespace Msfl2D {
          * @param g the graduation, i.e the signed distance from the origin.
          * @return the point of the line at the given graduation.
          */
-        Vec2D get_coo_grad(double g) const;
+        Vec2D get_coo_grad(real g) const;
 
         /**
          * Return the graduation along the line of the given point. Throw GeometryException if the point is not on the line.
@@ -107,7 +107,7 @@ namespace Msfl2D {
          * @param p The point to get the graduation, i.e the signed distance from the line origin.
          * @return the signed distance, or "graduation", of the point along the line
          */
-        double get_grad_coo(const Vec2D& p) const;
+        real get_grad_coo(const Vec2D& p) const;
 
         /**
          * Return the intersection point between two lines.
@@ -24,7 +24,7 @@ namespace Msfl2D {
         };
     }
 
-    double LineSegment::length() const {return segment.length();}
+    real LineSegment::length() const {return segment.length();}
 
     LineSegment LineSegment::intersection(const LineSegment &s1, const LineSegment &s2) {
         if (!Line::overlap(s1.line, s2.line)) {throw GeometryException("LineSegments must be on the same line to compute intersection.");}
@@ -33,20 +33,23 @@ namespace Msfl2D {
     }
 
     Vec2D LineSegment::intersection(const Line &l) const {
-        Vec2D line_intersection;
-        try {line_intersection = Line::intersection(line, l);}
-        catch (GeometryException& e) {
-            throw GeometryException("No intersection between the line & the segment.");
-        }
+        Vec2D point;
+        if (!intersection(l, point)) {throw GeometryException("No intersection between the line & the segment.");}
+        return point;
+    }
+
+    bool LineSegment::intersection(const Line &l, Vec2D &point) const {
+        // collinear lines never intersect
+        if (Vec2D::collinear(line.get_vec(), l.get_vec())) {return false;}
+        Vec2D line_intersection = Line::intersection(line, l);
 
         // check that the intersection point is inside the segment (and not outside)
-        double dist = line.get_grad_coo(line_intersection);
+        real dist = line.get_grad_coo(line_intersection);
         if (dist >= segment.min && dist <= segment.max) {
-            return line_intersection;
-        }
-        else {
-            throw GeometryException("No intersection between the line & the segment.");
+            point = line_intersection;
+            return true;
         }
+        return false;
     }
 
     Vec2D LineSegment::get_vec() const {
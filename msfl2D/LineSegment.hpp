@@ -42,6 +42,13 @@ namespace Msfl2D {
          */
         Vec2D intersection(const Line& line) const;
 
+        /**
+         * Compute the intersection point between the segment and a line, without throwing.
+         * @param point set to the intersection point, if any
+         * @return whether there is an intersection
+         */
+        bool intersection(const Line& line, Vec2D& point) const;
+
         /**
          * Return the coordinates of the end points of the segment.
          */
@@ -55,7 +62,7 @@ namespace Msfl2D {
         /**
          * Return the length of the segment
          */
-        double length() const;
+        real length() const;
 
         /**
          * Return the point in the middle of the segment.
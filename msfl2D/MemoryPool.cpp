@@ -0,0 +1,79 @@
+//
+// Created by myselfleo on 22/07/2023.
+//
+
+#include "MemoryPool.hpp"
+
+#include <new>
+
+namespace Msfl2D {
+    MemoryPool::MemoryPool(
+            std::size_t chunks_per_block,
+            std::shared_ptr<MemoryCounter> block_counter,
+            std::shared_ptr<MemoryCounter> chunk_counter
+            ):
+        chunks_per_block(chunks_per_block > 0 ? chunks_per_block : 1),
+        block_counter(std::move(block_counter)),
+        chunk_counter(std::move(chunk_counter)),
+        blocks(CountingAllocator<std::unique_ptr<unsigned char[]>>(this->block_counter))
+        {}
+
+    MemoryPool::~MemoryPool() {
+        if (block_counter != nullptr) {block_counter->remove(blocks_size);}
+    }
+
+    void* MemoryPool::allocate(std::size_t size) {
+        if (size == 0) {size = 1;}
+        if (size > MAX_CHUNK_SIZE) {
+            // Not pooled, but still counted as if it was a block holding a single chunk
+            void* chunk = ::operator new(size);
+            if (block_counter != nullptr) {block_counter->add(size);}
+            if (chunk_counter != nullptr) {chunk_counter->add(size);}
+            return chunk;
+        }
+
+        std::size_t size_class = (size - 1) / CHUNK_ALIGNMENT;
+        if (chunk_counter != nullptr) {chunk_counter->add((size_class + 1) * CHUNK_ALIGNMENT);}
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (free_chunks[size_class] == nullptr) {add_block(size_class);}
+        FreeChunk* chunk = free_chunks[size_class];
+        free_chunks[size_class] = chunk->next;
+        return chunk;
+    }
+
+    void MemoryPool::deallocate(void *chunk, std::size_t size) {
+        if (chunk == nullptr) {return;}
+        if (size == 0) {size = 1;}
+        if (size > MAX_CHUNK_SIZE) {
+            ::operator delete(chunk);
+            if (block_counter != nullptr) {block_counter->remove(size);}
+            if (chunk_counter != nullptr) {chunk_counter->remove(size);}
+            return;
+        }
+
+        std::size_t size_class = (size - 1) / CHUNK_ALIGNMENT;
+        if (chunk_counter != nullptr) {chunk_counter->remove((size_class + 1) * CHUNK_ALIGNMENT);}
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto free_chunk = static_cast<FreeChunk*>(chunk);
+        free_chunk->next = free_chunks[size_class];
+        free_chunks[size_class] = free_chunk;
+    }
+
+    void MemoryPool::add_block(std::size_t size_class) {
+        std::size_t chunk_size = (size_class + 1) * CHUNK_ALIGNMENT;
+
+        // new[] aligns the block for any fundamental type, and the chunk sizes are multiples of that alignment
+        blocks.emplace_back(new unsigned char[chunk_size * chunks_per_block]);
+        unsigned char* block = blocks.back().get();
+        blocks_size += chunk_size * chunks_per_block;
+        if (block_counter != nullptr) {block_counter->add(chunk_size * chunks_per_block);}
+
+        for (std::size_t i=chunks_per_block; i>0; i--) {
+            auto chunk = reinterpret_cast<FreeChunk*>(block + (i - 1) * chunk_size);
+            chunk->next = free_chunks[size_class];
+            free_chunks[size_class] = chunk;
+        }
+    }
+} // Msfl2D
@@ -0,0 +1,137 @@
+//
+// Created by myselfleo on 22/07/2023.
+//
+
+#ifndef MSFL2D_MEMORYPOOL_HPP
+#define MSFL2D_MEMORYPOOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "MemoryStats.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * Pool of small memory chunks, used to allocate the bodies & shapes created by a World.
+     *
+     * The chunks are grouped by size (rounded up to a multiple of CHUNK_ALIGNMENT), and carved out of large
+     * blocks. A released chunk is kept in a free list and given back by the next allocation of the same size, so
+     * creating & destroying objects of the same types doesn't allocate once the pool is warm. The blocks are only
+     * freed with the pool. Sizes above MAX_CHUNK_SIZE are not pooled.
+     *
+     * The pool can be used from several threads, as the objects it allocates may be released anywhere.
+     */
+    class MemoryPool {
+    public:
+        static constexpr std::size_t CHUNK_ALIGNMENT = alignof(std::max_align_t);
+        static constexpr std::size_t MAX_CHUNK_SIZE = 512;
+
+        /**
+         * Create an empty pool. Each block holds the given number of chunks.
+         * The memory of the blocks, and of the chunks in use, is counted in the given counters if they are not null.
+         */
+        explicit MemoryPool(
+                std::size_t chunks_per_block = 256,
+                std::shared_ptr<MemoryCounter> block_counter = nullptr,
+                std::shared_ptr<MemoryCounter> chunk_counter = nullptr
+                );
+
+        ~MemoryPool();
+
+        MemoryPool(const MemoryPool&) = delete;
+        MemoryPool& operator=(const MemoryPool&) = delete;
+
+        /**
+         * Return a chunk of at least the given size, aligned on CHUNK_ALIGNMENT.
+         */
+        void* allocate(std::size_t size);
+
+        /**
+         * Give back a chunk returned by allocate(), with the size it was allocated with.
+         */
+        void deallocate(void* chunk, std::size_t size);
+
+    private:
+        struct FreeChunk {
+            FreeChunk* next;
+        };
+
+        static constexpr std::size_t NB_SIZE_CLASSES = MAX_CHUNK_SIZE / CHUNK_ALIGNMENT;
+
+        std::size_t chunks_per_block;
+        std::mutex mutex;
+
+        std::shared_ptr<MemoryCounter> block_counter;
+        std::shared_ptr<MemoryCounter> chunk_counter;
+
+
+        // Free chunks of each size class, the n-th class holding chunks of (n+1) * CHUNK_ALIGNMENT bytes
+        FreeChunk* free_chunks[NB_SIZE_CLASSES] = {};
+        CountedVector<std::unique_ptr<unsigned char[]>> blocks;
+
+        // Total size of the blocks, in bytes
+        std::size_t blocks_size = 0;
+
+        /**
+         * Allocate a new block, cut into chunks of the given size class added to its free list.
+         */
+        void add_block(std::size_t size_class);
+    };
+
+
+    /**
+     * Standard allocator allocating from a MemoryPool. It keeps the pool alive, so an object allocated with it may
+     * outlive the World owning the pool (with std::allocate_shared, the allocator is stored with the object).
+     */
+    template<typename T>
+    class PoolAllocator {
+    public:
+        typedef T value_type;
+
+        static_assert(alignof(T) <= MemoryPool::CHUNK_ALIGNMENT, "Type too aligned to be allocated from a MemoryPool");
+
+        explicit PoolAllocator(std::shared_ptr<MemoryPool> pool): pool(std::move(pool)) {}
+
+        template<typename U>
+        PoolAllocator(const PoolAllocator<U>& other): pool(other.pool) {} // NOLINT(google-explicit-constructor)
+
+        T* allocate(std::size_t n) {
+            return static_cast<T*>(pool->allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, std::size_t n) {
+            pool->deallocate(p, n * sizeof(T));
+        }
+
+        template<typename U>
+        bool operator==(const PoolAllocator<U>& other) const {return pool == other.pool;}
+
+        template<typename U>
+        bool operator!=(const PoolAllocator<U>& other) const {return pool != other.pool;}
+
+    private:
+        template<typename U> friend class PoolAllocator;
+
+        std::shared_ptr<MemoryPool> pool;
+    };
+
+
+    /**
+     * Deleter of the objects constructed in a chunk of a MemoryPool, for std::shared_ptr.
+     */
+    template<typename T>
+    struct PoolDeleter {
+        std::shared_ptr<MemoryPool> pool;
+
+        void operator()(T* p) const {
+            p->~T();
+            pool->deallocate(p, sizeof(T));
+        }
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_MEMORYPOOL_HPP
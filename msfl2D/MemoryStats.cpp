@@ -0,0 +1,50 @@
+//
+// Created by myselfleo on 27/07/2023.
+//
+
+#include "MemoryStats.hpp"
+
+namespace Msfl2D {
+    MemoryCounter::MemoryCounter(MemoryCounter *parent):
+        parent(parent)
+        {}
+
+    void MemoryCounter::add(std::size_t size) {
+        std::size_t new_bytes = bytes.fetch_add(size, std::memory_order_relaxed) + size;
+
+        std::size_t current_peak = peak.load(std::memory_order_relaxed);
+        while (new_bytes > current_peak && !peak.compare_exchange_weak(current_peak, new_bytes, std::memory_order_relaxed)) {}
+
+        if (parent != nullptr) {parent->add(size);}
+    }
+
+    void MemoryCounter::remove(std::size_t size) {
+        bytes.fetch_sub(size, std::memory_order_relaxed);
+        if (parent != nullptr) {parent->remove(size);}
+    }
+
+    std::size_t MemoryCounter::get_bytes() const {
+        return bytes.load(std::memory_order_relaxed);
+    }
+
+    std::size_t MemoryCounter::get_peak() const {
+        return peak.load(std::memory_order_relaxed);
+    }
+
+
+    MemoryStats MemoryTracker::get_stats() const {
+        auto usage = [](const MemoryCounter& counter) -> MemoryUsage {
+            return {counter.get_bytes(), counter.get_peak()};
+        };
+
+        return {
+            usage(bodies), usage(pool), usage(pooled_objects), usage(vertices),
+            usage(joints), usage(contacts), usage(step), usage(snapshots), usage(commands), usage(queries), usage(total)
+        };
+    }
+
+    std::shared_ptr<MemoryCounter> MemoryTracker::share(const std::shared_ptr<MemoryTracker> &tracker, MemoryCounter MemoryTracker::* counter) {
+        // Aliasing constructor: the pointer owns the tracker, but points to the counter
+        return {tracker, &((*tracker).*counter)};
+    }
+} // Msfl2D
@@ -0,0 +1,189 @@
+//
+// Created by myselfleo on 27/07/2023.
+//
+
+#ifndef MSFL2D_MEMORYSTATS_HPP
+#define MSFL2D_MEMORYSTATS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace Msfl2D {
+
+    /**
+     * Number of bytes currently allocated by a part of the library, and highest value it reached.
+     * The counts can be updated from several threads.
+     */
+    class MemoryCounter {
+    public:
+        /**
+         * Create a counter at 0. The bytes counted are also added to the parent counter, if any.
+         */
+        explicit MemoryCounter(MemoryCounter* parent = nullptr);
+
+        MemoryCounter(const MemoryCounter&) = delete;
+        MemoryCounter& operator=(const MemoryCounter&) = delete;
+
+        /**
+         * Count an allocation of the given number of bytes.
+         */
+        void add(std::size_t size);
+
+        /**
+         * Count the release of the given number of bytes.
+         */
+        void remove(std::size_t size);
+
+        std::size_t get_bytes() const;
+
+        /**
+         * Return the highest number of bytes counted at once.
+         */
+        std::size_t get_peak() const;
+
+    private:
+        MemoryCounter* parent;
+        std::atomic<std::size_t> bytes{0};
+        std::atomic<std::size_t> peak{0};
+    };
+
+
+    /**
+     * Memory used by a part of the library, in bytes, and its high-water mark.
+     */
+    struct MemoryUsage {
+        std::size_t bytes;
+        std::size_t peak;
+    };
+
+
+    /**
+     * Memory used by a World, per subsystem (see World::memory_stats()).
+     */
+    struct MemoryStats {
+        /** Rows of the bodies (position, velocity, etc.), and arrays mapping the BodyIDs to them */
+        MemoryUsage bodies;
+        /** Blocks of the pool in which the world creates bodies & shapes (see World::create_body()) */
+        MemoryUsage pool;
+        /** Chunks of the pool in use by bodies & shapes. Those are included in `pool`. */
+        MemoryUsage pooled_objects;
+        /** Local & world-space vertices of the polygons */
+        MemoryUsage vertices;
+        /** Joints, and the table of their IDs */
+        MemoryUsage joints;
+        /** Contacts of the last step, kept to warm start the next one, and the contact events of the step */
+        MemoryUsage contacts;
+        /** Memory used during the steps: frame arena (pairs found by the broadphase, islands) & scratch buffers */
+        MemoryUsage step;
+        /** Snapshots of the state published after the steps (see World::get_snapshot()), read-only copies included */
+        MemoryUsage snapshots;
+        /** Nodes of the command queue (see World::get_command_queue()) */
+        MemoryUsage commands;
+        /** Tree of the shapes used by the spatial queries (see World::raycast()) */
+        MemoryUsage queries;
+        /** Sum of the above (pooled_objects excluded, as they are counted in the pool) */
+        MemoryUsage total;
+    };
+
+
+    /**
+     * Counters of the memory used by each subsystem of a World. It is shared with the objects that may outlive the
+     * world, like the memory pool.
+     */
+    struct MemoryTracker {
+        MemoryCounter total;
+        MemoryCounter bodies{&total};
+        MemoryCounter pool{&total};
+        MemoryCounter pooled_objects;
+        MemoryCounter vertices{&total};
+        MemoryCounter joints{&total};
+        MemoryCounter contacts{&total};
+        MemoryCounter step{&total};
+        MemoryCounter snapshots{&total};
+        MemoryCounter commands{&total};
+        MemoryCounter queries{&total};
+
+        /**
+         * Return the current values of the counters.
+         */
+        MemoryStats get_stats() const;
+
+        /**
+         * Return a shared pointer to one of the counters, keeping the whole tracker alive.
+         */
+        static std::shared_ptr<MemoryCounter> share(const std::shared_ptr<MemoryTracker>& tracker, MemoryCounter MemoryTracker::* counter);
+    };
+
+
+    /**
+     * Standard allocator counting the memory it allocates in a MemoryCounter (which it keeps alive). An allocator
+     * without counter allocates without counting, like std::allocator.
+     */
+    template<typename T>
+    class CountingAllocator {
+    public:
+        typedef T value_type;
+
+        // Containers keep counting in the same counter when they are assigned or swapped
+        typedef std::true_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        CountingAllocator() = default;
+
+        explicit CountingAllocator(std::shared_ptr<MemoryCounter> counter): counter(std::move(counter)) {}
+
+        template<typename U>
+        CountingAllocator(const CountingAllocator<U>& other): counter(other.counter) {} // NOLINT(google-explicit-constructor)
+
+        T* allocate(std::size_t n) {
+            T* p = static_cast<T*>(::operator new(n * sizeof(T)));
+            if (counter != nullptr) {counter->add(n * sizeof(T));}
+            return p;
+        }
+
+        void deallocate(T* p, std::size_t n) {
+            if (counter != nullptr) {counter->remove(n * sizeof(T));}
+            ::operator delete(p);
+        }
+
+        template<typename U>
+        bool operator==(const CountingAllocator<U>& other) const {return counter == other.counter;}
+
+        template<typename U>
+        bool operator!=(const CountingAllocator<U>& other) const {return counter != other.counter;}
+
+    private:
+        template<typename U> friend class CountingAllocator;
+
+        std::shared_ptr<MemoryCounter> counter;
+    };
+
+
+    /**
+     * Deleter of the objects allocated with new & counted in a MemoryCounter, for std::shared_ptr.
+     */
+    template<typename T>
+    struct CountingDeleter {
+        std::shared_ptr<MemoryCounter> counter;
+
+        void operator()(T* p) const {
+            delete p;
+            counter->remove(sizeof(T));
+        }
+    };
+
+
+    /**
+     * Vector whose memory is counted in a MemoryCounter.
+     */
+    template<typename T>
+    using CountedVector = std::vector<T, CountingAllocator<T>>;
+
+} // Msfl2D
+
+#endif //MSFL2D_MEMORYSTATS_HPP
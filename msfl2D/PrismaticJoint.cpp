@@ -0,0 +1,65 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#include "PrismaticJoint.hpp"
+
+#include <utility>
+
+namespace Msfl2D {
+    PrismaticJoint::PrismaticJoint(
+            BodyID id1, std::shared_ptr<Body> b1,
+            BodyID id2, std::shared_ptr<Body> b2,
+            const Vec2D &anchor, const Vec2D &axis
+            ): Joint(id1, std::move(b1), id2, std::move(b2), anchor, anchor) {
+        local_axis = body1->get_transform().rotation.inverse().rotate(axis.normalized());
+    }
+
+    Vec2D PrismaticJoint::get_axis() const {
+        return body1->get_transform().rotation.rotate(local_axis);
+    }
+
+
+    void PrismaticJoint::prepare(const BodyStorage &bodies, real delta_t) {
+        prepare_anchors(bodies);
+
+        Vec2D d = anchors_distance(bodies);
+        perpendicular = Vec2D::cross(1, bodies.rotations[index1].rotate(local_axis));
+
+        // The axis is attached to body 1, so the impulse acts on it at the position of anchor 2
+        arm1_cross = Vec2D::cross(d + arm1, perpendicular);
+        arm2_cross = Vec2D::cross(arm2, perpendicular);
+
+        real inv_mass = bodies.inv_masses[index1] + bodies.inv_masses[index2]
+                + bodies.inv_inertias[index1] * arm1_cross * arm1_cross
+                + bodies.inv_inertias[index2] * arm2_cross * arm2_cross;
+        mass = inv_mass > 0 ? 1 / inv_mass : 0;
+
+        bias = Vec2D::dot(d, perpendicular) * POSITION_CORRECTION / delta_t;
+
+        prepare_angle(bodies, delta_t);
+    }
+
+    void PrismaticJoint::warm_start(BodyStorage &bodies) {
+        apply_perpendicular_impulse(bodies, impulse);
+        warm_start_angle(bodies);
+    }
+
+    void PrismaticJoint::solve_velocity(BodyStorage &bodies) {
+        solve_angle(bodies);
+
+        real velocity = Vec2D::dot(bodies.velocities[index2] - bodies.velocities[index1], perpendicular)
+                + arm2_cross * bodies.angular_velocities[index2] - arm1_cross * bodies.angular_velocities[index1];
+        real lambda = -mass * (velocity + bias);
+        impulse += lambda;
+        apply_perpendicular_impulse(bodies, lambda);
+    }
+
+
+    void PrismaticJoint::apply_perpendicular_impulse(BodyStorage &bodies, real lambda) const {
+        bodies.velocities[index1] -= perpendicular * (lambda * bodies.inv_masses[index1]);
+        bodies.angular_velocities[index1] -= lambda * arm1_cross * bodies.inv_inertias[index1];
+        bodies.velocities[index2] += perpendicular * (lambda * bodies.inv_masses[index2]);
+        bodies.angular_velocities[index2] += lambda * arm2_cross * bodies.inv_inertias[index2];
+    }
+} // Msfl2D
@@ -0,0 +1,62 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#ifndef MSFL2D_PRISMATICJOINT_HPP
+#define MSFL2D_PRISMATICJOINT_HPP
+
+#include "Joint.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * Joint only allowing the 2 bodies to slide relative to each other along an axis, like on a rail.
+     * The bodies can't rotate relative to each other. The axis is attached to the first body, so it rotates with it.
+     * Created with World::add_prismatic_joint().
+     */
+    class PrismaticJoint: public Joint {
+    public:
+        /**
+         * Return the sliding axis, in world-space coordinates.
+         */
+        Vec2D get_axis() const;
+
+    protected:
+        friend class World;
+
+        /**
+         * Create a prismatic joint between the 2 bodies. The anchor is given in world-space coordinates, and the
+         * axis must not be null.
+         */
+        PrismaticJoint(
+                BodyID id1, std::shared_ptr<Body> b1,
+                BodyID id2, std::shared_ptr<Body> b2,
+                const Vec2D& anchor, const Vec2D& axis
+                );
+
+        void prepare(const BodyStorage& bodies, real delta_t) override;
+        void warm_start(BodyStorage& bodies) override;
+        void solve_velocity(BodyStorage& bodies) override;
+
+    private:
+        // Sliding axis, without the rotation of the first body
+        Vec2D local_axis;
+
+        // Normal of the sliding axis, lever arms of the impulse along it, effective mass & bias. Computed by prepare().
+        Vec2D perpendicular;
+        real arm1_cross = 0;
+        real arm2_cross = 0;
+        real mass = 0;
+        real bias = 0;
+
+        real impulse = 0;
+
+        /**
+         * Apply an impulse along the normal of the sliding axis.
+         */
+        void apply_perpendicular_impulse(BodyStorage& bodies, real lambda) const;
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_PRISMATICJOINT_HPP
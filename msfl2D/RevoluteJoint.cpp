@@ -0,0 +1,47 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#include "RevoluteJoint.hpp"
+
+#include <utility>
+
+namespace Msfl2D {
+    RevoluteJoint::RevoluteJoint(
+            BodyID id1, std::shared_ptr<Body> b1,
+            BodyID id2, std::shared_ptr<Body> b2,
+            const Vec2D &anchor
+            ): Joint(id1, std::move(b1), id2, std::move(b2), anchor, anchor) {}
+
+
+    void RevoluteJoint::prepare(const BodyStorage &bodies, real delta_t) {
+        prepare_anchors(bodies);
+
+        real inv_mass = bodies.inv_masses[index1] + bodies.inv_masses[index2];
+        real inv_i1 = bodies.inv_inertias[index1];
+        real inv_i2 = bodies.inv_inertias[index2];
+
+        // Effective mass matrix of the constraint (both anchors at the same place)
+        real k11 = inv_mass + inv_i1 * arm1.y * arm1.y + inv_i2 * arm2.y * arm2.y;
+        real k12 = -inv_i1 * arm1.x * arm1.y - inv_i2 * arm2.x * arm2.y;
+        real k22 = inv_mass + inv_i1 * arm1.x * arm1.x + inv_i2 * arm2.x * arm2.x;
+
+        real det = k11 * k22 - k12 * k12;
+        if (det != 0) {det = 1 / det;}
+        mass_col1 = Vec2D(k22 * det, -k12 * det);
+        mass_col2 = Vec2D(-k12 * det, k11 * det);
+
+        bias = anchors_distance(bodies) * (POSITION_CORRECTION / delta_t);
+    }
+
+    void RevoluteJoint::warm_start(BodyStorage &bodies) {
+        apply_impulse(bodies, impulse);
+    }
+
+    void RevoluteJoint::solve_velocity(BodyStorage &bodies) {
+        Vec2D v = relative_velocity(bodies) + bias;
+        Vec2D lambda = -(mass_col1 * v.x + mass_col2 * v.y);
+        impulse += lambda;
+        apply_impulse(bodies, lambda);
+    }
+} // Msfl2D
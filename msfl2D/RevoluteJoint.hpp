@@ -0,0 +1,44 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#ifndef MSFL2D_REVOLUTEJOINT_HPP
+#define MSFL2D_REVOLUTEJOINT_HPP
+
+#include "Joint.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * Joint pinning the 2 bodies together at a single point, around which they can rotate freely (like a hinge).
+     * Created with World::add_revolute_joint().
+     */
+    class RevoluteJoint: public Joint {
+    protected:
+        friend class World;
+
+        /**
+         * Create a revolute joint between the 2 bodies, rotating around the given anchor (in world-space coordinates).
+         */
+        RevoluteJoint(
+                BodyID id1, std::shared_ptr<Body> b1,
+                BodyID id2, std::shared_ptr<Body> b2,
+                const Vec2D& anchor
+                );
+
+        void prepare(const BodyStorage& bodies, real delta_t) override;
+        void warm_start(BodyStorage& bodies) override;
+        void solve_velocity(BodyStorage& bodies) override;
+
+    private:
+        // Inverse of the 2x2 effective mass matrix of the point constraint, stored by columns. Computed by prepare().
+        Vec2D mass_col1;
+        Vec2D mass_col2;
+        Vec2D bias;
+
+        Vec2D impulse;
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_REVOLUTEJOINT_HPP
@@ -0,0 +1,23 @@
+//
+// Created by myselfleo on 24/07/2023.
+//
+
+#ifndef MSFL2D_SCALAR_HPP
+#define MSFL2D_SCALAR_HPP
+
+namespace Msfl2D {
+
+    /**
+     * Floating point type used by the engine for every coordinate, velocity, mass, etc.
+     * It is double by default. Building with MSFL2D_SINGLE_PRECISION defined (see the CMake option of the same name)
+     * switches it to float, which halves the memory used by the vertices & the body storage, at the cost of precision.
+     */
+#ifdef MSFL2D_SINGLE_PRECISION
+    typedef float real;
+#else
+    typedef double real;
+#endif
+
+} // Msfl2D
+
+#endif //MSFL2D_SCALAR_HPP
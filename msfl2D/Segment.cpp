@@ -5,10 +5,12 @@
 #include "Segment.hpp"
 #include "Line.hpp"
 
+#include <algorithm>
+
 namespace Msfl2D {
     Segment::Segment() : min(0), max(0) {}
 
-    Segment::Segment(double p1, double p2) {
+    Segment::Segment(real p1, real p2) {
         // We sort the end points so the user don't have to. (the user is me)
         if (p1 > p2) {
             min = p2;
@@ -44,6 +46,12 @@ namespace Msfl2D {
     }
 
 
+    real Segment::overlap(const Segment &s1, const Segment &s2) {
+        // The intersection, if any, goes from the greatest min to the smallest max.
+        // If they are in the wrong order, the segments are separated by that distance.
+        return std::min(s1.max, s2.max) - std::max(s1.min, s2.min);
+    }
+
 
 
     std::ostream &operator<<(std::ostream &os, const Segment& seg) {
@@ -51,7 +59,7 @@ namespace Msfl2D {
         return os;
     }
 
-    double Segment::length() const {
+    real Segment::length() const {
         return max - min;
     }
 }
\ No newline at end of file
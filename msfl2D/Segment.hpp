@@ -17,8 +17,8 @@ namespace Msfl2D {
      */
     class Segment {
     public:
-        double min;
-        double max;
+        real min;
+        real max;
 
         /**
          * @brief Default constructor, creates an "empty" segment (min 0, max 0)
@@ -30,7 +30,7 @@ namespace Msfl2D {
          * @param p1 One of the two end points of the segment
          * @param p2 One of the two end points of the segment
          */
-        Segment(double p1, double p2);
+        Segment(real p1, real p2);
 
         /**
          * Check if two segments are intersecting (i.e. they share a portion of the line).
@@ -41,12 +41,21 @@ namespace Msfl2D {
          */
         static Segment intersection(const Segment& s1, const Segment& s2);
 
+        /**
+         * Return the signed overlap of two segments (on the same line).
+         * A positive value is the length of their intersection; a negative value is the distance separating them.
+         * @param s1 One of the 2 segments to check
+         * @param S2 One of the 2 segments to check
+         * @return the signed overlap of the segments
+         */
+        static real overlap(const Segment& s1, const Segment& s2);
+
 
 
         /**
          * Return the length of the segment
          */
-        double length() const;
+        real length() const;
 
 
         // Allow printing the segment data to the command-line
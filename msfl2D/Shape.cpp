@@ -7,12 +7,22 @@
 
 namespace Msfl2D {
     const Vec2D &Shape::get_position() const {
-        return position;
+        return transform.translation;
     }
 
-    double Shape::get_rotation() const {return rotation;}
+    real Shape::get_rotation() const {return transform.rotation.angle();}
 
-    std::shared_ptr<Body> Shape::get_body() const {
+    const Transform2D &Shape::get_transform() const {return transform;}
+
+    real Shape::get_area() const {return area;}
+
+    Vec2D Shape::get_centroid() const {
+        return transform.apply(centroid);
+    }
+
+    real Shape::get_inertia() const {return inertia;}
+
+    Body* Shape::get_body() const {
         return body;
     }
 } // Msfl2D
\ No newline at end of file
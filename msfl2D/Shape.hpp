@@ -7,12 +7,15 @@
 
 #include "Line.hpp"
 #include "LineSegment.hpp"
+#include "AABB.hpp"
+#include "Transform2D.hpp"
 
 #include <memory>
 
 namespace Msfl2D {
     // pre-declare body because the compiler wants it so bad
     class Body;
+    class VertexStorage;
 
     /**
      * Base class for the shapes used in the physic engine.
@@ -26,9 +29,39 @@ namespace Msfl2D {
         virtual ~Shape() = default;
 
         const Vec2D& get_position() const;
-        double get_rotation() const;
 
-        std::shared_ptr<Body> get_body() const;
+        /**
+         * Return the rotation of the shape, in radians, in [-pi, pi].
+         */
+        real get_rotation() const;
+
+        /**
+         * Return the transform of the shape, i.e. its position & rotation, converting the local coordinates of the
+         * shape into world-space coordinates.
+         */
+        const Transform2D& get_transform() const;
+
+        /**
+         * Return the area of the shape. This value is computed once, when the shape is constructed.
+         */
+        real get_area() const;
+
+        /**
+         * Return the centroid (center of mass) of the shape, in world-space coordinates.
+         * It may differ from the position of the shape, which is not always its center of mass.
+         */
+        Vec2D get_centroid() const;
+
+        /**
+         * Return the polar moment of inertia of the shape around its centroid, for a density of 1 (i.e. its
+         * polar second moment of area). This value is computed once, when the shape is constructed.
+         */
+        real get_inertia() const;
+
+        /**
+         * Return the body owning this shape, or nullptr if it's not added to a body.
+         */
+        Body* get_body() const;
 
         /**
          * Check if the given point is inside or outside the shape. This function should return true if the
@@ -45,14 +78,58 @@ namespace Msfl2D {
          */
         virtual LineSegment project(const Line& line) const = 0;
 
+        /**
+         * Return the axis-aligned bounding box of the shape, in world-space coordinates.
+         */
+        virtual AABB get_aabb() const = 0;
+
+        /**
+         * Compute where the ray going from `from` to `to` enters the shape, if it does before `max_fraction`.
+         * Rays starting inside the shape don't hit it.
+         * @param fraction set to the position of the hit along the ray, from 0 (`from`) to 1 (`to`)
+         * @param normal set to the normal of the side of the shape at the hit, normalized and pointing outwards
+         * @return whether the ray hits the shape
+         */
+        virtual bool raycast(const Vec2D& from, const Vec2D& to, real max_fraction, real& fraction, Vec2D& normal) const = 0;
+
     protected:
         friend class Body;
 
-        // Body owning this shape, set by the body.
-        std::shared_ptr<Body> body{};
+        // Body owning this shape, set by the body. It doesn't own the body, as the body owns the shape: the body
+        // resets it when the shape is removed or when the body is destroyed.
+        Body* body = nullptr;
+
+        // Position & rotation of the shape
+        Transform2D transform;
+
+        // Mass properties, computed by the derived classes when they are constructed.
+        // The centroid is relative to the position of the shape, without its rotation.
+        real area{};
+        Vec2D centroid;
+        real inertia{};
+
+
+        /**
+         * Called by the body each time it changed the transform of the shape, so the shape can update the values it
+         * caches in world-space.
+         */
+        virtual void transform_changed() {}
+
+        /**
+         * Move the data of the shape to the given storage (the storage of the body owning it).
+         */
+        virtual void attach(VertexStorage& /*new_storage*/) {}
 
-        Vec2D position;
-        double rotation{}; // in radians
+        /**
+         * Move the data of the shape from the storage it is attached to, to a storage of its own.
+         */
+        virtual void detach() {}
+
+        /**
+         * Remove the data of the shape from the storage it is attached to, without keeping it.
+         * Used when the shape is about to be destroyed with its body.
+         */
+        virtual void release() {}
     };
 
 } // Msfl2D
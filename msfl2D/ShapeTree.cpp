@@ -0,0 +1,74 @@
+//
+// Created by myselfleo on 02/08/2023.
+//
+
+#include "ShapeTree.hpp"
+
+#include <algorithm>
+
+namespace Msfl2D {
+    ShapeTree::ShapeTree(const std::shared_ptr<MemoryCounter>& counter):
+        items(CountingAllocator<Item>(counter)),
+        nodes(CountingAllocator<Node>(counter))
+        {}
+
+
+    void ShapeTree::update(const CountedVector<std::pair<BodyID, std::shared_ptr<Body>>> &bodies, std::uint64_t version) {
+        if (built_version.load(std::memory_order_acquire) == version) {return;}
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (built_version.load(std::memory_order_relaxed) == version) {return;}
+
+        items.clear();
+        for (auto& b: bodies) {
+            const auto& shapes = b.second->get_shapes();
+            std::uint32_t category = b.second->get_collision_category();
+            for (int i=0; i<shapes.size(); i++) {
+                items.push_back({shapes[i]->get_aabb(), shapes[i].get(), b.first, i, category});
+            }
+        }
+
+        nodes.clear();
+        if (!items.empty()) {build_node(0, items.size());}
+
+        built_version.store(version, std::memory_order_release);
+    }
+
+    int ShapeTree::build_node(int first, int count) {
+        int index = nodes.size();
+        nodes.push_back({});
+
+        AABB box = items[first].box;
+        Vec2D center = (box.min + box.max) / 2;
+        AABB centers(center, center);
+        for (int i=first + 1; i<first + count; i++) {
+            box = AABB::merge(box, items[i].box);
+            center = (items[i].box.min + items[i].box.max) / 2;
+            centers = AABB::merge(centers, AABB(center, center));
+        }
+
+        if (count <= LEAF_SIZE) {
+            nodes[index] = {box, first, count};
+            return index;
+        }
+
+        // Split at the median along the longest axis of the centers. The sum of the corners orders the boxes like
+        // their centers.
+        Vec2D extent = centers.max - centers.min;
+        bool along_x = extent.x >= extent.y;
+        int middle = first + count / 2;
+        std::nth_element(
+                items.begin() + first, items.begin() + middle, items.begin() + first + count,
+                [along_x](const Item& i1, const Item& i2) {
+                    return along_x
+                        ? i1.box.min.x + i1.box.max.x < i2.box.min.x + i2.box.max.x
+                        : i1.box.min.y + i1.box.max.y < i2.box.min.y + i2.box.max.y;
+                });
+
+        // The left child is the next node; nodes may be reallocated while building the children
+        build_node(first, middle - first);
+        int right = build_node(middle, first + count - middle);
+        nodes[index] = {box, right, 0};
+        return index;
+    }
+} // Msfl2D
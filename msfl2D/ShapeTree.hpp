@@ -0,0 +1,261 @@
+//
+// Created by myselfleo on 02/08/2023.
+//
+
+#ifndef MSFL2D_SHAPETREE_HPP
+#define MSFL2D_SHAPETREE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+
+#include "Body.hpp"
+#include "AABB.hpp"
+#include "MemoryStats.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * Shape crossed by a ray (see World::raycast()).
+     * @param body_id ID of the body owning the shape
+     * @param shape_index Index of the shape in its body
+     * @param point Point where the ray enters the shape, in world-space coordinates
+     * @param normal Normal of the side of the shape at that point, normalized and pointing outwards
+     * @param fraction Position of the point along the ray, from 0 (start of the ray) to 1 (end of the ray)
+     */
+    struct RaycastHit {
+        BodyID body_id;
+        int shape_index;
+        Vec2D point;
+        Vec2D normal;
+        real fraction;
+    };
+
+
+    /**
+     * Bounding volume hierarchy over the shapes of the bodies of a world, used by the spatial queries of the world
+     * so they only test the shapes close to what they look for.
+     *
+     * The bodies move at every step, so rather than updating the tree as they move, it is rebuilt from scratch the
+     * first time it is queried after a change of the bodies: the shapes are split in halves at the median of their
+     * centers along the longest axis, so the depth of the tree is the log2 of the number of shapes. Its arrays are
+     * reused, so once warm, rebuilding it doesn't allocate memory.
+     *
+     * Several threads may query the tree at the same time: the first one to find it out of date rebuilds it while
+     * the others wait.
+     */
+    class ShapeTree {
+    public:
+        /**
+         * Shape stored in the tree, with its bounding box.
+         */
+        struct Item {
+            AABB box;
+            const Shape* shape;
+            BodyID body_id;
+            int shape_index;
+            // Collision categories of the body
+            std::uint32_t category;
+        };
+
+        /**
+         * Create an empty tree, counting the memory of its arrays in the given counter if it is not null.
+         */
+        explicit ShapeTree(const std::shared_ptr<MemoryCounter>& counter = nullptr);
+
+        ShapeTree(const ShapeTree&) = delete;
+        ShapeTree& operator=(const ShapeTree&) = delete;
+
+        /**
+         * Rebuild the tree from the shapes of the given bodies, unless it was already built for the same version of
+         * their storage (see BodyStorage::version).
+         */
+        void update(const CountedVector<std::pair<BodyID, std::shared_ptr<Body>>>& bodies, std::uint64_t version);
+
+        /**
+         * Call function(item) for each item whose box is crossed by the ray going from `from` to `to`, before the
+         * fraction `max_fraction` of the ray. The nearest boxes are visited first. The function may lower
+         * `max_fraction` (through its own reference to it) to skip the farther boxes, and returns false to stop.
+         */
+        template<typename F>
+        void query_ray(const Vec2D& from, const Vec2D& to, real& max_fraction, const F& function) const;
+
+        /**
+         * Call function(item) for each item whose box overlaps the given box. The function returns false to stop.
+         */
+        template<typename F>
+        void query_aabb(const AABB& box, const F& function) const;
+
+    private:
+        struct Node {
+            AABB box;
+            // For the leaves, index of their first item, and number of items. For the other nodes, index of the right
+            // child (the left one is the next node), and 0.
+            int first;
+            int count;
+        };
+
+        static constexpr int LEAF_SIZE = 4;
+
+        // The tree being balanced, its depth never gets close to this
+        static constexpr int MAX_DEPTH = 64;
+
+        CountedVector<Item> items;
+        CountedVector<Node> nodes;
+
+        // Version of the storage of the bodies the tree was built for, and lock of the threads rebuilding it
+        std::atomic<std::uint64_t> built_version{std::numeric_limits<std::uint64_t>::max()};
+        std::mutex mutex;
+
+        /**
+         * Build the subtree of the `count` items starting at `first`, reordering them, and return the index of its
+         * root node.
+         */
+        int build_node(int first, int count);
+
+        /**
+         * Slab test: return whether the ray (with the given direction & inverse direction) crosses the box before
+         * `max_fraction`, and set `fraction` to the fraction at which it enters it (0 if it starts inside).
+         */
+        static bool ray_enters(
+                const AABB& box,
+                const Vec2D& from,
+                const Vec2D& direction,
+                const Vec2D& inv_direction,
+                real max_fraction,
+                real& fraction
+                );
+    };
+
+
+    template<typename F>
+    void ShapeTree::query_ray(const Vec2D &from, const Vec2D &to, real &max_fraction, const F &function) const {
+        if (nodes.empty()) {return;}
+
+        Vec2D direction = to - from;
+        Vec2D inv_direction = {direction.x != 0 ? 1 / direction.x : 0, direction.y != 0 ? 1 / direction.y : 0};
+
+        // Nodes left to visit, with the fraction at which the ray enters them. Each visit pops a node and pushes
+        // at most its 2 children, so the stack never holds more nodes than the depth of the tree plus one.
+        int stack[MAX_DEPTH];
+        real enter_fractions[MAX_DEPTH];
+        int size = 0;
+
+        real fraction;
+        if (!ray_enters(nodes[0].box, from, direction, inv_direction, max_fraction, fraction)) {return;}
+        stack[size] = 0;
+        enter_fractions[size++] = fraction;
+
+        while (size > 0) {
+            size--;
+            int index = stack[size];
+
+            // The shapes found since the node was pushed may have moved the end of the ray before it
+            if (enter_fractions[size] > max_fraction) {continue;}
+
+            const Node& node = nodes[index];
+            if (node.count > 0) {
+                for (int i=node.first; i<node.first + node.count; i++) {
+                    if (!ray_enters(items[i].box, from, direction, inv_direction, max_fraction, fraction)) {continue;}
+                    if (!function(items[i])) {return;}
+                }
+                continue;
+            }
+
+            int left = index + 1;
+            int right = node.first;
+            real left_fraction;
+            real right_fraction;
+            bool has_left = ray_enters(nodes[left].box, from, direction, inv_direction, max_fraction, left_fraction);
+            bool has_right = ray_enters(nodes[right].box, from, direction, inv_direction, max_fraction, right_fraction);
+
+            // The nearest child is pushed last, so it is visited first and may shorten the ray for the other one
+            if (has_left && has_right && left_fraction < right_fraction) {
+                stack[size] = right;
+                enter_fractions[size++] = right_fraction;
+                stack[size] = left;
+                enter_fractions[size++] = left_fraction;
+            }
+            else {
+                if (has_left) {
+                    stack[size] = left;
+                    enter_fractions[size++] = left_fraction;
+                }
+                if (has_right) {
+                    stack[size] = right;
+                    enter_fractions[size++] = right_fraction;
+                }
+            }
+        }
+    }
+
+    template<typename F>
+    void ShapeTree::query_aabb(const AABB &box, const F &function) const {
+        if (nodes.empty()) {return;}
+
+        // Each visit pops a node and pushes at most its 2 children, like query_ray()
+        int stack[MAX_DEPTH];
+        int size = 0;
+        stack[size++] = 0;
+
+        while (size > 0) {
+            int index = stack[--size];
+            const Node& node = nodes[index];
+            if (!AABB::overlap(node.box, box)) {continue;}
+
+            if (node.count > 0) {
+                for (int i=node.first; i<node.first + node.count; i++) {
+                    if (!AABB::overlap(items[i].box, box)) {continue;}
+                    if (!function(items[i])) {return;}
+                }
+                continue;
+            }
+
+            stack[size++] = node.first;
+            stack[size++] = index + 1;
+        }
+    }
+
+    inline bool ShapeTree::ray_enters(
+            const AABB &box,
+            const Vec2D &from,
+            const Vec2D &direction,
+            const Vec2D &inv_direction,
+            real max_fraction,
+            real &fraction
+            ) {
+        real enter = 0;
+        real exit = max_fraction;
+
+        // A ray parallel to an axis crosses the slab of that axis everywhere or nowhere
+        if (direction.x == 0) {
+            if (from.x < box.min.x || from.x > box.max.x) {return false;}
+        }
+        else {
+            real t1 = (box.min.x - from.x) * inv_direction.x;
+            real t2 = (box.max.x - from.x) * inv_direction.x;
+            if (t1 > t2) {std::swap(t1, t2);}
+            if (t1 > enter) {enter = t1;}
+            if (t2 < exit) {exit = t2;}
+        }
+
+        if (direction.y == 0) {
+            if (from.y < box.min.y || from.y > box.max.y) {return false;}
+        }
+        else {
+            real t1 = (box.min.y - from.y) * inv_direction.y;
+            real t2 = (box.max.y - from.y) * inv_direction.y;
+            if (t1 > t2) {std::swap(t1, t2);}
+            if (t1 > enter) {enter = t1;}
+            if (t2 < exit) {exit = t2;}
+        }
+
+        if (enter > exit) {return false;}
+        fraction = enter;
+        return true;
+    }
+
+} // Msfl2D
+
+#endif //MSFL2D_SHAPETREE_HPP
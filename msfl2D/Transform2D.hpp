@@ -0,0 +1,118 @@
+//
+// Created by myselfleo on 25/07/2023.
+//
+
+#ifndef MSFL2D_TRANSFORM2D_HPP
+#define MSFL2D_TRANSFORM2D_HPP
+
+#include "Vec2D.hpp"
+
+#include <cmath>
+
+namespace Msfl2D {
+
+    /**
+     * A rotation in a 2D space, stored as the cosine & sine of its angle (i.e. a unit complex number).
+     * Rotating a vector only takes a few multiplications, and rotations are composed by multiplying them,
+     * so the angle never needs to be wrapped.
+     */
+    template<typename T>
+    class Rotor2 {
+    public:
+        T c;
+        T s;
+
+        /** Rotation of angle 0 */
+        constexpr Rotor2(): c(1), s(0) {}
+
+        /** Rotation with the given cosine & sine */
+        constexpr Rotor2(T cos, T sin): c(cos), s(sin) {}
+
+        /** Rotation of the given angle, in radians, counterclock-wise */
+        explicit Rotor2(T angle): c(std::cos(angle)), s(std::sin(angle)) {}
+
+        /**
+         * Return the angle of the rotation, in radians, in [-pi, pi].
+         */
+        T angle() const {return std::atan2(s, c);}
+
+        /**
+         * Return whether this is the rotation of angle 0.
+         */
+        constexpr bool is_identity() const {return s == 0 && c == 1;}
+
+        /**
+         * Return the rotation undoing this one.
+         */
+        constexpr Rotor2 inverse() const {return {c, -s};}
+
+        /**
+         * Return the rotated vector.
+         */
+        constexpr Vec2<T> rotate(const Vec2<T>& v) const {return {v.x * c - v.y * s, v.x * s + v.y * c};}
+
+        /**
+         * Return the rotation with the same angle, but of length exactly 1. Rotors composed many times slowly
+         * drift away from a length of 1 due to rounding errors.
+         */
+        Rotor2 normalized() const {
+            T length = std::sqrt(c*c + s*s);
+            return {c / length, s / length};
+        }
+
+        /** Composition of 2 rotations: the angle of the result is the sum of their angles. */
+        constexpr Rotor2 operator*(const Rotor2& other) const {return {c * other.c - s * other.s, s * other.c + c * other.s};}
+        constexpr Rotor2& operator*=(const Rotor2& other) {return *this = *this * other;}
+    };
+
+
+    /**
+     * A rotation followed by a translation. Applying it to a point converts it from a local space (like the space of
+     * the vertices of a shape) to the space of the transform (like the world).
+     */
+    template<typename T>
+    class Transform2 {
+    public:
+        Vec2<T> translation;
+        Rotor2<T> rotation;
+
+        constexpr Transform2() = default;
+        constexpr Transform2(const Vec2<T>& translation, const Rotor2<T>& rotation):
+            translation(translation),
+            rotation(rotation)
+            {}
+
+        /**
+         * Return the point of local coordinates p, in the space of the transform.
+         */
+        constexpr Vec2<T> apply(const Vec2<T>& p) const {return rotation.rotate(p) + translation;}
+
+        /**
+         * Return the local coordinates of the point p, given in the space of the transform.
+         */
+        constexpr Vec2<T> apply_inverse(const Vec2<T>& p) const {return rotation.inverse().rotate(p - translation);}
+
+        /**
+         * Rotate the whole transform around the given center (in the space of the transform).
+         */
+        constexpr void rotate(const Rotor2<T>& r, const Vec2<T>& center) {
+            translation = r.rotate(translation - center) + center;
+            rotation = r * rotation;
+        }
+
+        /** Composition of 2 transforms: other is applied first. */
+        constexpr Transform2 operator*(const Transform2& other) const {
+            return {apply(other.translation), rotation * other.rotation};
+        }
+    };
+
+
+    /**
+     * Rotation & transform of the type used by the engine.
+     */
+    typedef Rotor2<real> Rotor2D;
+    typedef Transform2<real> Transform2D;
+
+} // Msfl2D
+
+#endif //MSFL2D_TRANSFORM2D_HPP
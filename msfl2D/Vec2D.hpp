@@ -5,6 +5,9 @@
 #ifndef P2D_VEC2D_HPP
 #define P2D_VEC2D_HPP
 
+#include "Scalar.hpp"
+
+#include <cmath>
 #include <iostream>
 
 
@@ -14,31 +17,40 @@ namespace Msfl2D {
     class Line;
 
     /**
-     * A Vector in a 2D space.
+     * A Vector in a 2D space, whose coordinates are of type T (float or double).
+     * The engine uses Vec2D, i.e. vectors of the `real` type.
+     *
+     * The operations are defined in the header so they can be inlined, and most of them are constexpr. Only the
+     * ones involving a Line are compiled in the library, for both Vec2<float> & Vec2<double>.
      */
-    class Vec2D {
+    template<typename T>
+    class Vec2 {
     public:
-        double x;
-        double y;
+        T x;
+        T y;
 
         /** Vector of length zero */
-        const static Vec2D ZERO;
+        const static Vec2 ZERO;
 
         /** Default constructor */
-        Vec2D(): x(0), y(0) {}
+        constexpr Vec2(): x(0), y(0) {}
 
         /** Base constructor */
-        Vec2D(double xx, double yy): x(xx), y(yy) {}
+        constexpr Vec2(T xx, T yy): x(xx), y(yy) {}
+
+        /** Conversion from a vector of another scalar type */
+        template<typename U>
+        constexpr explicit Vec2(const Vec2<U>& v): x(static_cast<T>(v.x)), y(static_cast<T>(v.y)) {}
 
         /**
          * Returns the norm of the vector, i.e. its length.
          */
-        double norm() const;
+        T norm() const {return std::sqrt(x*x + y*y);}
 
         /**
          * Returns a normalized version of the vector, i.e. same direction but with a length of 1.
          */
-        Vec2D normalized() const;
+        Vec2 normalized() const {return *this / norm();}
 
         /**
          * Returns the dot product of 2 vectors.
@@ -46,17 +58,27 @@ namespace Msfl2D {
          * @param v2 a Vec2D
          * @return the dot product of the two vectors
          */
-        static double dot(const Vec2D& v1, const Vec2D& v2);
+        static constexpr T dot(const Vec2& v1, const Vec2& v2) {return v1.x * v2.x + v1.y * v2.y;}
 
         /**
          * Returns the cross product of 2 vectors.
          * The cross product of 2D vectors is not a vector like in 3D but a scalar.
-         * This function is equivalent to Vec2D::det().
+         * This function is equivalent to Vec2::det().
          * @param v1 a Vec2D
          * @param v2 a Vec2D
          * @return the cross product of the two vectors
          */
-         static double cross(const Vec2D& v1, const Vec2D& v2);
+        static constexpr T cross(const Vec2& v1, const Vec2& v2) {return v1.x * v2.y - v1.y * v2.x;}
+
+        /**
+         * Returns the cross product of a scalar and a vector. The scalar is considered as a vector along the z
+         * axis, so the result is the vector rotated by 90 degrees counterclock-wise and multiplied by the scalar.
+         * This is mostly used to compute the velocity of a point of a rotating body.
+         * @param s a scalar
+         * @param v a Vec2D
+         * @return the cross product of the scalar and the vector
+         */
+        static constexpr Vec2 cross(T s, const Vec2& v) {return {-s * v.y, s * v.x};}
 
 
         /**
@@ -65,7 +87,9 @@ namespace Msfl2D {
          * @param v2 second point
          * @return the square of the distance
          */
-        static double distance_squared(const Vec2D& v1, const Vec2D& v2);
+        static constexpr T distance_squared(const Vec2& v1, const Vec2& v2) {
+            return (v1.x - v2.x) * (v1.x - v2.x) + (v1.y - v2.y) * (v1.y - v2.y);
+        }
 
         /**
          * Returns the distance between 2 points represented by the 2 Vec2D.
@@ -73,30 +97,30 @@ namespace Msfl2D {
          * @param v2 second point
          * @return the distance
          */
-        static double distance(const Vec2D& v1, const Vec2D& v2);
+        static T distance(const Vec2& v1, const Vec2& v2) {return std::sqrt(distance_squared(v1, v2));}
 
         /**
          * Return the determinant of the 2x2 matrix formed by the 2 vectors stacked next to each other as column vectors.
-         * This function is equivalent to Vec2D::cross().
+         * This function is equivalent to Vec2::cross().
          * @return The determinant of the 2x2 matrix (v1 v2)
          */
-        static double det(const Vec2D& v1, const Vec2D& v2);
+        static constexpr T det(const Vec2& v1, const Vec2& v2) {return v1.x * v2.y - v1.y * v2.x;}
 
 
         /**
          * Project the point onto the line, return the distance from the origin of the line.
          */
-        double project(const Line& line) const;
+        T project(const Line& line) const;
 
         /**
          * Return the minimal distance between the point and the line.
          */
-        double distance(const Line& line) const;
+        T distance(const Line& line) const;
 
         /**
          * Return the square of the minimal distance between the point and the line.
          */
-        double distance_squared(const Line& line) const;
+        T distance_squared(const Line& line) const;
 
 
         /**
@@ -104,7 +128,11 @@ namespace Msfl2D {
          * @param angle the angle of rotation, in radians.
          * @return The rotated vector.
          */
-        Vec2D rotate(double angle) const;
+        Vec2 rotate(T angle) const {
+            T c = std::cos(angle);
+            T s = std::sin(angle);
+            return {x * c - y * s, x * s + y * c};
+        }
 
         /**
          * Return the rotated vector around the given point by the given angle counterclock-wise.
@@ -112,38 +140,61 @@ namespace Msfl2D {
          * @param center the center of the rotation
          * @return The rotated vector.
          */
-        Vec2D rotate(double angle, const Vec2D& center) const;
+        Vec2 rotate(T angle, const Vec2& center) const {return (*this - center).rotate(angle) + center;}
 
         /** Return whether the 2 Vec2D are collinear or not. */
-        static bool collinear(const Vec2D& v1, const Vec2D& v2);
+        static constexpr bool collinear(const Vec2& v1, const Vec2& v2) {return cross(v1, v2) == 0;}
 
 
         // Operator overloading for base types
-        bool operator==(const Vec2D& other) const;
-        bool operator!=(const Vec2D& other) const;
-
-        Vec2D operator+(const Vec2D& other) const;
-        Vec2D& operator+=(const Vec2D& other);
-
-        Vec2D operator-(const Vec2D& other) const;
-        Vec2D& operator-=(const Vec2D& other);
-
-        Vec2D operator*(double s) const;
-        Vec2D& operator*=(double s);
-
-        Vec2D operator/(double s) const;
-        Vec2D& operator/=(double s);
-
-        Vec2D operator-() const;
-
-
-        //  operators
-        friend std::ostream& operator<<(std::ostream& os, const Vec2D& v);
+        constexpr bool operator==(const Vec2& other) const {return x == other.x && y == other.y;}
+        constexpr bool operator!=(const Vec2& other) const {return x != other.x || y != other.y;}
+
+        constexpr Vec2 operator+(const Vec2& other) const {return {x + other.x, y + other.y};}
+        constexpr Vec2& operator+=(const Vec2& other) {
+            x += other.x;
+            y += other.y;
+            return *this;
+        }
+
+        constexpr Vec2 operator-(const Vec2& other) const {return {x - other.x, y - other.y};}
+        constexpr Vec2& operator-=(const Vec2& other) {
+            x -= other.x;
+            y -= other.y;
+            return *this;
+        }
+
+        constexpr Vec2 operator*(T s) const {return {x*s, y*s};}
+        constexpr Vec2& operator*=(T s) {
+            x *= s;
+            y *= s;
+            return *this;
+        }
+
+        constexpr Vec2 operator/(T s) const {return {x/s, y/s};}
+        constexpr Vec2& operator/=(T s) {
+            x /= s;
+            y /= s;
+            return *this;
+        }
+
+        constexpr Vec2 operator-() const {return {-x, -y};}
+    };
 
-    private:
+    template<typename T>
+    const Vec2<T> Vec2<T>::ZERO = {0, 0};
 
+    //  operators
+    template<typename T>
+    std::ostream& operator<<(std::ostream& os, const Vec2<T>& v) {
+        os << "(" << v.x << ", " << v.y << ")";
+        return os;
+    }
 
-    };
+    /**
+     * Vector of the type used by the engine.
+     */
+    typedef Vec2<real> Vec2D;
 } // Msfl2D
 
 
@@ -0,0 +1,86 @@
+//
+// Created by myselfleo on 26/07/2023.
+//
+
+#include "VertexStorage.hpp"
+#include "ConvexPolygon.hpp"
+
+#include <algorithm>
+
+namespace Msfl2D {
+    VertexStorage::VertexStorage(const std::shared_ptr<MemoryCounter> &counter):
+        local_vertices(CountingAllocator<Vec2D>(counter)),
+        world_vertices(CountingAllocator<Vec2D>(counter)),
+        ranges(CountingAllocator<Range>(counter))
+        {}
+
+    int VertexStorage::size() const {
+        return local_vertices.size();
+    }
+
+    void VertexStorage::add(ConvexPolygon *handle, int count) {
+        const Vec2D* previous_data = local_vertices.data();
+
+        ranges.push_back({size(), count, handle});
+        local_vertices.resize(local_vertices.size() + count);
+        world_vertices.resize(world_vertices.size() + count);
+
+        // Growing the arrays may have moved every range
+        if (local_vertices.data() != previous_data) {update_handles();}
+        else {handle->set_vertex_range(this, ranges.size() - 1, ranges.back().offset);}
+    }
+
+    void VertexStorage::reserve(int nb_vertices) {
+        if (nb_vertices <= local_vertices.capacity()) {return;}
+
+        local_vertices.reserve(nb_vertices);
+        world_vertices.reserve(nb_vertices);
+        update_handles();
+    }
+
+    void VertexStorage::remove(int range) {
+        ranges[range].handle = nullptr;
+        nb_free_vertices += ranges[range].count;
+
+        // The removed ranges at the end are simply dropped
+        while (!ranges.empty() && ranges.back().handle == nullptr) {
+            nb_free_vertices -= ranges.back().count;
+            local_vertices.resize(ranges.back().offset);
+            world_vertices.resize(ranges.back().offset);
+            ranges.pop_back();
+        }
+
+        if (nb_free_vertices * 2 > size()) {compact();}
+    }
+
+    void VertexStorage::compact() {
+        int nb_ranges = 0;
+        int nb_vertices = 0;
+
+        for (Range& range: ranges) {
+            if (range.handle == nullptr) {continue;}
+
+            // The ranges only move towards the start, so copying forward never overwrites a range not moved yet
+            if (range.offset != nb_vertices) {
+                std::copy_n(local_vertices.begin() + range.offset, range.count, local_vertices.begin() + nb_vertices);
+                std::copy_n(world_vertices.begin() + range.offset, range.count, world_vertices.begin() + nb_vertices);
+                range.offset = nb_vertices;
+            }
+
+            ranges[nb_ranges++] = range;
+            nb_vertices += range.count;
+        }
+
+        ranges.resize(nb_ranges);
+        local_vertices.resize(nb_vertices);
+        world_vertices.resize(nb_vertices);
+        nb_free_vertices = 0;
+        update_handles();
+    }
+
+    void VertexStorage::update_handles() {
+        for (int i=0; i<ranges.size(); i++) {
+            if (ranges[i].handle != nullptr) {ranges[i].handle->set_vertex_range(this, i, ranges[i].offset);}
+        }
+    }
+} // Msfl2D
@@ -0,0 +1,85 @@
+//
+// Created by myselfleo on 26/07/2023.
+//
+
+#ifndef MSFL2D_VERTEXSTORAGE_HPP
+#define MSFL2D_VERTEXSTORAGE_HPP
+
+#include "Vec2D.hpp"
+#include "MemoryStats.hpp"
+
+#include <vector>
+
+namespace Msfl2D {
+
+    class ConvexPolygon;
+
+    /**
+     * Storage of the vertices of the polygons of a World, as 2 contiguous arrays: the vertices relative to the
+     * polygons, and their world-space position, updated each time a polygon moves. Each polygon owns a range of
+     * consecutive vertices, so the collision detection reads the vertices of a polygon from a single place, next to
+     * those of the polygons added just before & after it.
+     *
+     * Removing a polygon leaves a hole in the arrays. Once the holes take more than half of the arrays, the ranges are
+     * moved back together, in the same order. Each time the vertices move in memory, the polygons are updated.
+     */
+    class VertexStorage {
+    public:
+        CountedVector<Vec2D> local_vertices;
+        CountedVector<Vec2D> world_vertices;
+
+
+        /**
+         * Create an empty storage. Its memory is counted in the given counter if it is not null.
+         */
+        explicit VertexStorage(const std::shared_ptr<MemoryCounter>& counter = nullptr);
+
+
+        /**
+         * Return the number of vertices of the storage, including the holes left by removed polygons.
+         */
+        int size() const;
+
+        /**
+         * Add a range of the given number of vertices at the end of the storage, for the given polygon.
+         * The polygon is updated to use the new range; the vertices must then be copied to it.
+         */
+        void add(ConvexPolygon* handle, int count);
+
+        /**
+         * Reserve memory for the given number of vertices, so that adding ranges up to that number doesn't allocate.
+         */
+        void reserve(int nb_vertices);
+
+        /**
+         * Remove the range at the given index (the index of the range of a polygon is given by the polygon).
+         */
+        void remove(int range);
+
+    private:
+        struct Range {
+            int offset;
+            int count;
+            // Polygon owning the range, or nullptr if the range was removed
+            ConvexPolygon* handle;
+        };
+
+        // Ranges of the polygons, in the order of their offsets
+        CountedVector<Range> ranges;
+
+        int nb_free_vertices = 0;
+
+        /**
+         * Move the ranges still in use to the start of the arrays, and drop the removed ones.
+         */
+        void compact();
+
+        /**
+         * Give to each polygon the current location of its range.
+         */
+        void update_handles();
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_VERTEXSTORAGE_HPP
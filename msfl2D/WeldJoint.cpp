@@ -0,0 +1,32 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#include "WeldJoint.hpp"
+
+#include <utility>
+
+namespace Msfl2D {
+    WeldJoint::WeldJoint(
+            BodyID id1, std::shared_ptr<Body> b1,
+            BodyID id2, std::shared_ptr<Body> b2,
+            const Vec2D &anchor
+            ): RevoluteJoint(id1, std::move(b1), id2, std::move(b2), anchor) {}
+
+
+    void WeldJoint::prepare(const BodyStorage &bodies, real delta_t) {
+        RevoluteJoint::prepare(bodies, delta_t);
+        prepare_angle(bodies, delta_t);
+    }
+
+    void WeldJoint::warm_start(BodyStorage &bodies) {
+        RevoluteJoint::warm_start(bodies);
+        warm_start_angle(bodies);
+    }
+
+    void WeldJoint::solve_velocity(BodyStorage &bodies) {
+        // The rotation is solved first, as it changes the velocity of the anchors
+        solve_angle(bodies);
+        RevoluteJoint::solve_velocity(bodies);
+    }
+} // Msfl2D
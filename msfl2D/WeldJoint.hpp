@@ -0,0 +1,37 @@
+//
+// Created by myselfleo on 18/07/2023.
+//
+
+#ifndef MSFL2D_WELDJOINT_HPP
+#define MSFL2D_WELDJOINT_HPP
+
+#include "RevoluteJoint.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * Joint gluing the 2 bodies together: they are pinned at a single point like with a revolute joint, and
+     * they also keep the rotation they had relative to each other when the joint was created.
+     * Created with World::add_weld_joint().
+     */
+    class WeldJoint: public RevoluteJoint {
+    protected:
+        friend class World;
+
+        /**
+         * Create a weld joint between the 2 bodies, pinned at the given anchor (in world-space coordinates).
+         */
+        WeldJoint(
+                BodyID id1, std::shared_ptr<Body> b1,
+                BodyID id2, std::shared_ptr<Body> b2,
+                const Vec2D& anchor
+                );
+
+        void prepare(const BodyStorage& bodies, real delta_t) override;
+        void warm_start(BodyStorage& bodies) override;
+        void solve_velocity(BodyStorage& bodies) override;
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_WELDJOINT_HPP
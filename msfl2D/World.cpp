@@ -6,47 +6,186 @@
 #include "MsflExceptions.hpp"
 #include "CollisionDetector.hpp"
 #include "CollisionResolver.hpp"
+#include "DistanceJoint.hpp"
+#include "RevoluteJoint.hpp"
+#include "PrismaticJoint.hpp"
+#include "WeldJoint.hpp"
 
-#include <random>
-#include <climits>
+#include <algorithm>
+#include <tuple>
+#include <cmath>
+#include <cstring>
 
 
 
 namespace Msfl2D {
-    World::World() {
-        // init RNG generator
-        std::random_device rd;
-        rng_gen.seed(rd());
+    namespace {
+        /**
+         * Order of the contacts, by the IDs of their bodies.
+         */
+        bool contact_less(const ContactConstraint& c1, const ContactConstraint& c2) {
+            return std::tie(c1.body1_id, c1.body2_id) < std::tie(c2.body1_id, c2.body2_id);
+        }
+    }
+
+
+    World::World():
+        World(std::make_shared<JobSystem>(1))
+        {}
+
+    World::World(std::shared_ptr<JobSystem> job_system):
+        memory(std::make_shared<MemoryTracker>()),
+        bodies(CountingAllocator<std::pair<BodyID, std::shared_ptr<Body>>>(MemoryTracker::share(memory, &MemoryTracker::bodies))),
+        pool(std::make_shared<MemoryPool>(
+                256,
+                MemoryTracker::share(memory, &MemoryTracker::pool),
+                MemoryTracker::share(memory, &MemoryTracker::pooled_objects)
+                )),
+        body_slots(CountingAllocator<BodySlot>(MemoryTracker::share(memory, &MemoryTracker::bodies))),
+        free_body_slots(CountingAllocator<std::uint32_t>(MemoryTracker::share(memory, &MemoryTracker::bodies))),
+        body_storage(std::make_unique<BodyStorage>(
+                MemoryTracker::share(memory, &MemoryTracker::bodies),
+                MemoryTracker::share(memory, &MemoryTracker::vertices)
+                )),
+        joints(CountingAllocator<std::pair<JointID, std::shared_ptr<Joint>>>(MemoryTracker::share(memory, &MemoryTracker::joints))),
+        contacts(CountingAllocator<ContactConstraint>(MemoryTracker::share(memory, &MemoryTracker::contacts))),
+        previous_contacts(contacts.get_allocator()),
+        contact_events(CountingAllocator<ContactEvent>(MemoryTracker::share(memory, &MemoryTracker::contacts))),
+        job_system(std::move(job_system)),
+        frame_arena(64 * 1024, MemoryTracker::share(memory, &MemoryTracker::step)),
+        command_queue(std::make_unique<CommandQueue>(MemoryTracker::share(memory, &MemoryTracker::commands))),
+        shape_tree(std::make_unique<ShapeTree>(MemoryTracker::share(memory, &MemoryTracker::queries))),
+        islands(CountingAllocator<Island>(MemoryTracker::share(memory, &MemoryTracker::step))),
+        island_parents(islands.get_allocator()),
+        position_deltas(islands.get_allocator())
+        {
+        if (this->job_system == nullptr) {throw SimulationException("The JobSystem of a world can't be null");}
+
+        // The storage itself is counted with the rows
+        memory->bodies.add(sizeof(BodyStorage));
+    }
+
+    World::~World() {
+        wait_async_step();
+
+        // The bodies may outlive the world, so they take their values back
+        for (auto& b: bodies) {release_body(b.second);}
+        if (body_storage != nullptr) {memory->bodies.remove(sizeof(BodyStorage));}
     }
 
 
     BodyID World::add_body(const std::shared_ptr<Body>& body) {
-        BodyID id = new_id();
-        bodies.insert(std::make_pair(id, body));
+        if (body->own_storage == nullptr) {throw SimulationException("Tried to add a body already in a world");}
+        body->attach(*body_storage);
+        return insert_body(body);
+    }
+
+    void World::add_bodies(const std::vector<std::shared_ptr<Body>> &new_bodies, std::vector<BodyID> &ids) {
+        reserve_bodies(bodies.size() + new_bodies.size());
+        ids.reserve(ids.size() + new_bodies.size());
+        for (auto& b: new_bodies) {ids.push_back(add_body(b));}
+    }
+
+    BodyID World::create_body() {
+        // The body is constructed in a chunk of the pool, and so is the control block of the shared_ptr
+        void* memory = pool->allocate(sizeof(Body));
+        Body* body;
+        try {body = new (memory) Body(*body_storage);}
+        catch (...) {
+            pool->deallocate(memory, sizeof(Body));
+            throw;
+        }
+
+        return insert_body(std::shared_ptr<Body>(body, PoolDeleter<Body>{pool}, PoolAllocator<Body>(pool)));
+    }
+
+    void World::create_bodies(int count, std::vector<BodyID> &ids) {
+        reserve_bodies(bodies.size() + count);
+        ids.reserve(ids.size() + count);
+        for (int i=0; i<count; i++) {ids.push_back(create_body());}
+    }
+
+    void World::reserve_bodies(int nb) {
+        body_storage->reserve(nb);
+        bodies.reserve(nb);
+        body_slots.reserve(nb);
+    }
+
+    BodyID World::insert_body(const std::shared_ptr<Body> &body) {
+        // Reuse the slot of a removed body if possible
+        std::uint32_t slot;
+        if (!free_body_slots.empty()) {
+            slot = free_body_slots.back();
+            free_body_slots.pop_back();
+        }
+        else {
+            slot = body_slots.size();
+            body_slots.push_back({-1, 1});
+        }
+
+        BodyID id = (static_cast<BodyID>(body_slots[slot].generation) << 32) | slot;
+        body->id = id;
+
+        // The body is added at the end of both the dense array & the storage, so they stay in the same order
+        body_slots[slot].dense_index = bodies.size();
+        bodies.emplace_back(id, body);
         return id;
     }
 
     void World::remove_body(BodyID id) {
-        if (bodies.find(id) == bodies.end()) {throw SimulationException("Tried to remove inexistant body");}
-        bodies.erase(id);
+        int dense_index = find_body(id);
+        if (dense_index == -1) {throw SimulationException("Tried to remove inexistant body");}
+
+        // remove the joints attached to the body
+        if (!bodies[dense_index].second->joints.empty()) {
+            std::vector<JointID> attached;
+            for (auto& j: joints) {
+                if (j.second->body1_id == id || j.second->body2_id == id) {attached.push_back(j.first);}
+            }
+            for (JointID j: attached) {remove_joint(j);}
+        }
+
+        // Same as the storage: the last body takes the place of the removed one
+        release_body(bodies[dense_index].second);
+        if (dense_index != bodies.size() - 1) {
+            bodies[dense_index] = std::move(bodies.back());
+            body_slots[static_cast<std::uint32_t>(bodies[dense_index].first)].dense_index = dense_index;
+        }
+        bodies.pop_back();
+
+        // The generation of the slot changes, so the id of the removed body becomes invalid
+        BodySlot& slot = body_slots[static_cast<std::uint32_t>(id)];
+        slot.dense_index = -1;
+        slot.generation++;
+        if (slot.generation == 0) {slot.generation = 1;}
+        free_body_slots.push_back(static_cast<std::uint32_t>(id));
     }
 
-    std::shared_ptr<Body> World::get_body(BodyID id) const {
-        try {return bodies.at(id);}
-        catch (std::out_of_range& _) {throw SimulationException("Tried to access inexistant body");}
+    void World::remove_bodies(const std::vector<BodyID> &ids) {
+        for (BodyID id: ids) {remove_body(id);}
     }
 
-    BodyID World::new_id() {
-        // Uniform distribution over every unsigned long integers
-        std::uniform_int_distribution<unsigned long> distribution(1, ULONG_MAX);
+    void World::release_body(const std::shared_ptr<Body> &body) {
+        // No need to keep the values of a body that will be destroyed with the world's reference
+        if (body.use_count() == 1) {body->release();}
+        else {body->detach();}
+    }
 
-        // Find an unused id. It should be
-        BodyID id;
-        do {
-            id = distribution(rng_gen);
-        } while (bodies.find(id) != bodies.end());
+    std::shared_ptr<Body> World::get_body(BodyID id) const {
+        int dense_index = find_body(id);
+        if (dense_index == -1) {throw SimulationException("Tried to access inexistant body");}
+        return bodies[dense_index].second;
+    }
 
-        return id;
+    bool World::has_body(BodyID id) const {
+        return find_body(id) != -1;
+    }
+
+    int World::find_body(BodyID id) const {
+        std::uint32_t slot = static_cast<std::uint32_t>(id);
+        std::uint32_t generation = static_cast<std::uint32_t>(id >> 32);
+        if (slot >= body_slots.size() || body_slots[slot].generation != generation) {return -1;}
+        return body_slots[slot].dense_index;
     }
 
 
@@ -54,95 +193,734 @@ namespace Msfl2D {
         return bodies.size();
     }
 
-    const std::unordered_map<BodyID, std::shared_ptr<Body>> &World::get_bodies() const {
+    const CountedVector<std::pair<BodyID, std::shared_ptr<Body>>> &World::get_bodies() const {
         return bodies;
     }
 
 
 
-    void World::update(double delta_t) {
-        // Steps:
-        // 1. Update body (apply forces)
-        // 2. Reset forces and recompute them
-        // 3. Resolve collision
+    template<typename T, typename... Args>
+    std::shared_ptr<Joint> World::make_joint(Args&&... args) {
+        std::shared_ptr<MemoryCounter> counter = MemoryTracker::share(memory, &MemoryTracker::joints);
+        T* joint = new T(std::forward<Args>(args)...);
+        counter->add(sizeof(T));
+        return {joint, CountingDeleter<T>{counter}, CountingAllocator<T>(counter)};
+    }
+
+    JointID World::add_distance_joint(BodyID body1, BodyID body2, const Vec2D &anchor1, const Vec2D &anchor2) {
+        auto b = get_joint_bodies(body1, body2);
+        return add_joint(make_joint<DistanceJoint>(body1, b.first, body2, b.second, anchor1, anchor2));
+    }
+
+    JointID World::add_revolute_joint(BodyID body1, BodyID body2, const Vec2D &anchor) {
+        auto b = get_joint_bodies(body1, body2);
+        return add_joint(make_joint<RevoluteJoint>(body1, b.first, body2, b.second, anchor));
+    }
+
+    JointID World::add_prismatic_joint(BodyID body1, BodyID body2, const Vec2D &anchor, const Vec2D &axis) {
+        if (axis == Vec2D::ZERO) {throw SimulationException("The axis of a prismatic joint can't be null");}
+        auto b = get_joint_bodies(body1, body2);
+        return add_joint(make_joint<PrismaticJoint>(body1, b.first, body2, b.second, anchor, axis));
+    }
+
+    JointID World::add_weld_joint(BodyID body1, BodyID body2, const Vec2D &anchor) {
+        auto b = get_joint_bodies(body1, body2);
+        return add_joint(make_joint<WeldJoint>(body1, b.first, body2, b.second, anchor));
+    }
+
+    void World::remove_joint(JointID id) {
+        int index = find_joint(id);
+        if (index == -1) {throw SimulationException("Tried to remove inexistant joint");}
+
+        Joint* joint = joints[index].second.get();
+        for (auto& body: {joint->body1, joint->body2}) {
+            body->joints.erase(std::remove(body->joints.begin(), body->joints.end(), joint), body->joints.end());
+        }
+
+        // Erase rather than swap with the last joint, so the joints stay sorted
+        joints.erase(joints.begin() + index);
+    }
+
+    std::shared_ptr<Joint> World::get_joint(JointID id) const {
+        int index = find_joint(id);
+        if (index == -1) {throw SimulationException("Tried to access inexistant joint");}
+        return joints[index].second;
+    }
+
+    int World::find_joint(JointID id) const {
+        auto it = std::lower_bound(joints.begin(), joints.end(), id, [](const auto& j, JointID i) {return j.first < i;});
+        if (it == joints.end() || it->first != id) {return -1;}
+        return it - joints.begin();
+    }
+
+    int World::nb_joints() const {
+        return joints.size();
+    }
+
+    const std::shared_ptr<JobSystem> &World::get_job_system() const {
+        return job_system;
+    }
+
+    MemoryStats World::memory_stats() const {
+        return memory->get_stats();
+    }
+
+    std::uint64_t World::state_hash() const {
+        // FNV-1a over the bytes of the values. The bodies are visited in the order of their slots, which doesn't
+        // depend on the order of the rows of the storage.
+        std::uint64_t hash = 14695981039346656037ull;
+        auto add = [&hash](const auto& value) {
+            unsigned char bytes[sizeof(value)];
+            std::memcpy(bytes, &value, sizeof(value));
+            for (unsigned char b: bytes) {
+                hash ^= b;
+                hash *= 1099511628211ull;
+            }
+        };
+
+        for (auto& slot: body_slots) {
+            if (slot.dense_index == -1) {continue;}
+            const auto& body = bodies[slot.dense_index];
+            int row = body.second->index;
+
+            add(body.first);
+            add(body_storage->positions[row].x);
+            add(body_storage->positions[row].y);
+            add(body_storage->rotations[row].c);
+            add(body_storage->rotations[row].s);
+            add(body_storage->velocities[row].x);
+            add(body_storage->velocities[row].y);
+            add(body_storage->angular_velocities[row]);
+        }
+        return hash;
+    }
+
+    JointID World::add_joint(const std::shared_ptr<Joint> &joint) {
+        // The IDs only increase, so adding the joint at the end keeps the joints sorted
+        JointID id = next_joint_id++;
+        joints.emplace_back(id, joint);
+        joint->body1->joints.push_back(joint.get());
+        joint->body2->joints.push_back(joint.get());
+        return id;
+    }
+
+    std::pair<std::shared_ptr<Body>, std::shared_ptr<Body>> World::get_joint_bodies(BodyID body1, BodyID body2) const {
+        if (body1 == body2) {throw SimulationException("Tried to connect a body to itself");}
+        return {get_body(body1), get_body(body2)};
+    }
+
+
+
+    void World::update(real delta_t) {
+        wait_async_step();
+        update_step(delta_t);
+    }
+
+    std::future<void> World::update_async(real delta_t) {
+        wait_async_step();
+
+        // The promise is shared, as the functions of the tasks must be copyable
+        auto promise = std::make_shared<std::promise<void>>();
+        std::future<void> future = promise->get_future();
+        async_step = get_async_job_system().submit([this, delta_t, promise]() {
+            try {
+                update_step(delta_t);
+                promise->set_value();
+            }
+            catch (...) {promise->set_exception(std::current_exception());}
+        });
+        return future;
+    }
+
+    void World::wait_async_step() {
+        if (async_step == nullptr) {return;}
+
+        // The exceptions of the step are given to the future, so waiting doesn't throw
+        get_async_job_system().wait(async_step);
+        async_step = nullptr;
+    }
+
+    JobSystem &World::get_async_job_system() {
+        // A JobSystem with a single thread only runs its jobs when they are waited for, so the step wouldn't run
+        // in the background
+        if (job_system->get_concurrency() > 1) {return *job_system;}
+        if (async_job_system == nullptr) {async_job_system = std::make_shared<JobSystem>(2);}
+        return *async_job_system;
+    }
+
+
+    const ShapeTree &World::get_shape_tree() const {
+        shape_tree->update(bodies, body_storage->version);
+        return *shape_tree;
+    }
+
+    bool World::raycast(const Vec2D &from, const Vec2D &to, RaycastHit &hit, std::uint32_t mask) const {
+        real max_fraction = 1;
+        bool found = false;
+
+        // Each hit shortens the ray, so the shapes behind it are skipped
+        get_shape_tree().query_ray(from, to, max_fraction, [&](const ShapeTree::Item& item) {
+            if ((item.category & mask) == 0) {return true;}
+
+            real fraction;
+            Vec2D normal;
+            if (item.shape->raycast(from, to, max_fraction, fraction, normal)) {
+                hit = {item.body_id, item.shape_index, from + (to - from) * fraction, normal, fraction};
+                max_fraction = fraction;
+                found = true;
+            }
+            return true;
+        });
+        return found;
+    }
+
+    void World::raycast_all(
+            const Vec2D &from, const Vec2D &to, std::vector<RaycastHit> &hits, std::uint32_t mask
+            ) const {
+        std::size_t first = hits.size();
+        real max_fraction = 1;
+
+        get_shape_tree().query_ray(from, to, max_fraction, [&](const ShapeTree::Item& item) {
+            if ((item.category & mask) == 0) {return true;}
+
+            real fraction;
+            Vec2D normal;
+            if (item.shape->raycast(from, to, max_fraction, fraction, normal)) {
+                hits.push_back({item.body_id, item.shape_index, from + (to - from) * fraction, normal, fraction});
+            }
+            return true;
+        });
+
+        std::sort(hits.begin() + first, hits.end(), [](const RaycastHit& h1, const RaycastHit& h2) {
+            return std::tie(h1.fraction, h1.body_id, h1.shape_index) < std::tie(h2.fraction, h2.body_id, h2.shape_index);
+        });
+    }
+
+    bool World::raycast_any(const Vec2D &from, const Vec2D &to, std::uint32_t mask) const {
+        real max_fraction = 1;
+        bool found = false;
+
+        get_shape_tree().query_ray(from, to, max_fraction, [&](const ShapeTree::Item& item) {
+            if ((item.category & mask) == 0) {return true;}
+
+            real fraction;
+            Vec2D normal;
+            found = item.shape->raycast(from, to, max_fraction, fraction, normal);
+            return !found;
+        });
+        return found;
+    }
+
+    int World::query_point(const Vec2D &point, BodyID *ids, int max_ids, std::uint32_t mask) const {
+        check_query_buffer(ids, max_ids);
+        int count = 0;
+
+        get_shape_tree().query_aabb(AABB(point, point), [&](const ShapeTree::Item& item) {
+            if ((item.category & mask) == 0 || !item.shape->is_point_inside(point)) {return true;}
+
+            // A body is only counted for the first of its shapes containing the point
+            const auto& shapes = item.shape->get_body()->get_shapes();
+            for (int i=0; i<item.shape_index; i++) {
+                if (shapes[i]->is_point_inside(point)) {return true;}
+            }
+
+            if (count < max_ids) {ids[count] = item.body_id;}
+            count++;
+            return true;
+        });
+        return count;
+    }
+
+    int World::query_aabb(const AABB &box, BodyID *ids, int max_ids, std::uint32_t mask) const {
+        check_query_buffer(ids, max_ids);
+        int count = 0;
+
+        get_shape_tree().query_aabb(box, [&](const ShapeTree::Item& item) {
+            if ((item.category & mask) == 0) {return true;}
+
+            // A body is only counted for the first of its shapes overlapping the box
+            const auto& shapes = item.shape->get_body()->get_shapes();
+            for (int i=0; i<item.shape_index; i++) {
+                if (AABB::overlap(shapes[i]->get_aabb(), box)) {return true;}
+            }
 
-        // This order might seem weird, but resolving collision AFTER updating the body prevent a situation
-        // where the shapes are overlapping after calling update().
-        // They overlap after step 1, then are separated in step 3.
+            if (count < max_ids) {ids[count] = item.body_id;}
+            count++;
+            return true;
+        });
+        return count;
+    }
+
+    void World::check_query_buffer(const BodyID *ids, int max_ids) {
+        if (max_ids < 0) {throw SimulationException("The size of the buffer of a query must be >= 0");}
+        if (ids == nullptr && max_ids != 0) {throw SimulationException("The buffer of a query can't be null");}
+    }
+
+    const CountedVector<ContactEvent> &World::get_contact_events() const {
+        return contact_events;
+    }
+
+    CommandQueue &World::get_command_queue() {
+        return *command_queue;
+    }
+
+    void World::execute_commands() {
+        // The commands are given by other threads, which can't know whether their bodies still exist, so the
+        // invalid ones are ignored rather than throwing
+        command_queue->execute([this](Command& command) {
+            if (command.type == CommandType::ADD_BODY) {
+                if (command.body != nullptr && command.body->own_storage != nullptr) {add_body(command.body);}
+                return;
+            }
+
+            int dense_index = find_body(command.id);
+            if (dense_index == -1) {return;}
+            Body& body = *bodies[dense_index].second;
+
+            switch (command.type) {
+                case CommandType::REMOVE_BODY: remove_body(command.id); break;
+                case CommandType::MOVE: body.move(command.vector); break;
+                case CommandType::APPLY_IMPULSE: body.apply_impulse(command.vector, command.point); break;
+                case CommandType::SET_VELOCITY:
+                    body.set_velocity(command.vector);
+                    body.set_angular_velocity(command.angular_velocity);
+                    break;
+                default: break;
+            }
+        });
+    }
+
+    void World::set_snapshots_enabled(bool enabled) {
+        wait_async_step();
+
+        if (enabled) {
+            if (snapshot_recycler == nullptr) {
+                snapshot_recycler = std::make_shared<SnapshotRecycler>(MemoryTracker::share(memory, &MemoryTracker::snapshots));
+            }
+            publish_snapshot();
+        }
+        else {
+            std::atomic_store(&snapshot, std::shared_ptr<const WorldSnapshot>());
+            snapshot_recycler = nullptr;
+        }
+    }
+
+    bool World::get_snapshots_enabled() const {
+        return snapshot_recycler != nullptr;
+    }
+
+    std::shared_ptr<const WorldSnapshot> World::get_snapshot() const {
+        return std::atomic_load(&snapshot);
+    }
 
+    void World::publish_snapshot() {
+        // The readers only get the published snapshot, so the new one is written without them seeing it
+        std::shared_ptr<WorldSnapshot> new_snapshot = snapshot_recycler->make_snapshot();
+        WorldSnapshot& s = *new_snapshot;
 
-        // Update each body with the forces computed in the last update and the friction of the environment
         for (auto& b: bodies) {
-            b.second->apply_forces(delta_t);
-            b.second->velocity *= (1 - friction * delta_t);
-            //b.second->angular_vel *= (1 - friction * delta_t);
+            const Body& body = *b.second;
+            int row = body.index;
+            s.bodies.push_back({
+                b.first,
+                body_storage->positions[row],
+                body_storage->rotations[row],
+                body_storage->velocities[row],
+                body_storage->angular_velocities[row],
+                body.get_mass(),
+                body.is_dynamic(),
+                body.nb_colliding_points,
+                static_cast<int>(s.shapes.size()),
+                static_cast<int>(body.get_shapes().size())
+            });
+
+            for (auto& shape: body.get_shapes()) {
+                int first_vertex = s.vertices.size();
+                auto polygon = dynamic_cast<const ConvexPolygon*>(shape.get());
+                if (polygon != nullptr) {
+                    for (int i=0; i<polygon->nb_vertices(); i++) {s.vertices.push_back(polygon->get_global_vertex(i));}
+                }
+                s.shapes.push_back({shape->get_position(), first_vertex, static_cast<int>(s.vertices.size()) - first_vertex});
+            }
         }
 
+        // The contacts of the last step were swapped into previous_contacts
+        for (auto& c: previous_contacts) {
+            const SATResult& r = c.result;
+            s.contacts.push_back({
+                c.body1_id, c.body2_id, r.minimum_penetration_vector, r.depth, r.nb_collision_points,
+                {r.collision_points[0], r.collision_points[1]}
+            });
+        }
+
+        s.contact_events.assign(contact_events.begin(), contact_events.end());
+
+        // The last snapshot goes back to the recycler once its readers release it
+        std::atomic_store(&snapshot, std::shared_ptr<const WorldSnapshot>(std::move(new_snapshot)));
+    }
+
+
+
+    void World::update_step(real delta_t) {
+        // Steps:
+        // 1. Update the velocity of the bodies (apply forces)
+        // 2. Detect the contacts
+        // 3. Solve the velocities, so the bodies don't approach each other at the contacts & follow the joints
+        // 4. Move the bodies according to their velocity
+        // 5. Separate the bodies still intersecting
+
+        // This order might seem weird, but solving velocities BEFORE moving the bodies prevent a situation
+        // where the shapes are overlapping after calling update(): what's left of the overlap after step 4
+        // is removed in step 5.
+
+
+        // Apply the changes requested by other threads since the last step
+        execute_commands();
+
+        // Update each body with the forces computed in the last update, the constant force of the world
+        // (most of the time, gravity) and the friction of the environment. The velocity of kinematic bodies is
+        // only changed by the user.
+        apply_forces(delta_t);
+
         nb_collision_points = 0;
         nb_collision_vectors = 0;
 
-        // Reset forces & apply the constant
-        // force (most of the time, gravity) to every body
-        for (auto& b: bodies) {
-            b.second->reset_forces();       // Clear forces from the last step
-            b.second->register_force(constant_force);
 
-            // Reset collision point number for following collision detection
-            b.second->nb_colliding_points = 0;
+
+        // todo: should be based on shapes & not bodies
+        FrameVector<std::tuple<Body*, Body*>> pairs = find_pairs(delta_t);
+
+        // Narrow phase: test each pair. The tests only read the bodies, so they run in parallel, each pair
+        // writing to its own slot of the results.
+        FrameVector<SATResult> results(pairs.size(), SATResult::no_collision(), ArenaAllocator<SATResult>(frame_arena));
+        auto test_pairs = [&](int first, int last) {
+            for (int i=first; i<last; i++) {
+                Body* b1 = std::get<0>(pairs[i]);
+                Body* b2 = std::get<1>(pairs[i]);
+                auto bs1 = static_cast<const ConvexPolygon*>(b1->get_shapes()[0].get());
+                auto bs2 = static_cast<const ConvexPolygon*>(b2->get_shapes()[0].get());
+
+                // Shapes closer than the distance the bodies can travel towards each other during the next step
+                // produce a speculative contact, so fast bodies are stopped before going through each other.
+                Vec2D relative_velocity = body_storage->velocities[b1->index] - body_storage->velocities[b2->index];
+                real speculative_distance = relative_velocity.norm() * delta_t + SPECULATIVE_MARGIN;
+                results[i] = CollisionDetector::sat(bs1, bs2, speculative_distance);
+            }
+        };
+        if (pairs.size() < PARALLEL_NARROWPHASE_THRESHOLD) {test_pairs(0, pairs.size());}
+        else {job_system->parallel_for(0, pairs.size(), PAIR_GRAIN, test_pairs);}
+
+        // Merge the results in the order of the pairs, so the contacts don't depend on how the tests were split,
+        // and count the collision points of the bodies
+        contacts.clear();
+        for (std::size_t p=0; p<pairs.size(); p++) {
+            SATResult& collision_data = results[p];
+
+            // Return early if CollisionDetector lies (its not our problem)
+            if (!collision_data.collide || collision_data.nb_collision_points == 0) {continue;}
+
+            // Speculative contacts are not touching yet, so they don't count as collisions.
+            if (!collision_data.is_speculative()) {
+                collision_data.inc_body->nb_colliding_points += collision_data.nb_collision_points;
+            }
+
+            // add collision data to output arrays. Speculative contacts are not actual collisions.
+            if (!collision_data.is_speculative()) for (int i=0; i <collision_data.nb_collision_points; i++) {
+                if (nb_collision_points == MAX_COLLISION_POINTS) {break;}
+                collision_points[nb_collision_points] = collision_data.collision_points[i];
+                nb_collision_points++;
+            }
+
+            if (nb_collision_vectors != MAX_COLLISION_VECTORS && collision_data.depth > 0) {
+                Vec2D p1 = collision_data.collision_points[0];
+                Vec2D p2 = p1 - collision_data.minimum_penetration_vector.normalized() * collision_data.depth;
+                collision_vector[nb_collision_vectors] = LineSegment(p1, p2);
+                nb_collision_vectors++;
+            }
+
+            contacts.emplace_back(collision_data, std::get<0>(pairs[p])->id, std::get<1>(pairs[p])->id);
         }
 
+        warm_start_contacts();
+        find_contact_events();
 
 
-        // todo: collision detection & resolution
-        // todo: should be based on shapes & not bodies
+        // Velocity phase: compute the impulses of every contact & joint, island by island
+        build_islands();
+        for (auto& island: islands) {
+            island.solve_velocities(*body_storage, delta_t, velocity_iterations);
+        }
 
-        // temporary: compute each pairs of bodies
-        std::vector<std::tuple<std::shared_ptr<Body>, std::shared_ptr<Body>>> pairs;
-        for (auto& b1: bodies) {
-            for (auto& b2: bodies) {
-                if (b1.first < b2.first) {
-                    pairs.emplace_back(b1.second, b2.second);
+        integrate(delta_t);
+
+        // Position phase: separate the intersecting bodies. The displacements are computed for every contact at
+        // once, then applied to the bodies.
+        BodyStorage& storage = *body_storage;
+        position_deltas.assign(storage.size(), Vec2D::ZERO);
+        CollisionResolver::solve_positions(
+                storage, contacts, position_deltas, position_iterations, linear_slop, delta_t
+                );
+        for_each_body(PARALLEL_INTEGRATION_THRESHOLD, [&](int first, int last) {
+            for (int i=first; i<last; i++) {
+                const Vec2D& delta = position_deltas[i];
+                if (delta == Vec2D::ZERO) {continue;}
+
+                storage.positions[i] += delta;
+                storage.handles[i]->transform_shapes(delta, Rotor2D());
+            }
+        });
+
+        // The contacts of this step will warm start the next one
+        std::swap(contacts, previous_contacts);
+
+        // The bodies moved, so the tree of the spatial queries is out of date
+        body_storage->version++;
+
+        // Release the data of the step
+        islands.clear();
+        frame_arena.reset();
+
+        if (snapshot_recycler != nullptr) {publish_snapshot();}
+    }
+
+
+    template<typename F>
+    void World::for_each_body(int threshold, const F &function) {
+        int nb = body_storage->size();
+        if (nb < threshold) {function(0, nb);}
+        else {job_system->parallel_for(0, nb, BODY_GRAIN, function);}
+    }
+
+    void World::apply_forces(real delta_t) {
+        BodyStorage& storage = *body_storage;
+        real damping = 1 - friction * delta_t;
+
+        for_each_body(PARALLEL_FORCES_THRESHOLD, [&](int first, int last) {
+            for (int i=first; i<last; i++) {
+                if (storage.types[i] == BodyType::DYNAMIC) {
+                    Vec2D acceleration = storage.forces[i] * storage.inv_masses[i] + constant_force;
+                    storage.velocities[i] = (storage.velocities[i] + acceleration * delta_t) * damping;
+
+                    real angular_acceleration = storage.torques[i] * storage.inv_inertias[i];
+                    storage.angular_velocities[i] = (storage.angular_velocities[i] + angular_acceleration * delta_t) * damping;
                 }
+
+                // Clear forces for the next step
+                storage.forces[i] = Vec2D::ZERO;
+                storage.torques[i] = 0;
+
+                // Reset collision point number for the following collision detection
+                storage.handles[i]->nb_colliding_points = 0;
             }
+        });
+    }
+
+
+    void World::integrate(real delta_t) {
+        BodyStorage& storage = *body_storage;
+
+        // Each body only moves its own shapes, whose vertices don't overlap with those of the other bodies
+        for_each_body(PARALLEL_INTEGRATION_THRESHOLD, [&](int first, int last) {
+            for (int i=first; i<last; i++) {
+                Vec2D displacement = storage.velocities[i] * delta_t;
+                real angle = storage.angular_velocities[i] * delta_t;
+                if (displacement == Vec2D::ZERO && angle == 0) {continue;}
+
+                storage.positions[i] += displacement;
+
+                // Composing the rotations keeps them in [-pi, pi], so they never need to be wrapped
+                Rotor2D rotation(angle);
+                storage.rotations[i] = (rotation * storage.rotations[i]).normalized();
+
+                // The shapes store their own position & rotation, so they must follow the body
+                storage.handles[i]->transform_shapes(displacement, rotation);
+            }
+        });
+    }
+
+
+    void World::warm_start_contacts() {
+        // Sorting the contacts by body IDs makes them easy to find in the next step, and makes the order in which
+        // they are solved independent from the order of the pairs.
+        std::sort(contacts.begin(), contacts.end(), contact_less);
+
+        for (auto& c: contacts) {
+            auto previous = std::lower_bound(previous_contacts.begin(), previous_contacts.end(), c, contact_less);
+            if (previous == previous_contacts.end() || contact_less(c, *previous)) {continue;}
+            CollisionResolver::match_impulses(c, *previous);
         }
+    }
 
-        // check for collision, resolve if needed
-        for (auto& p: pairs) {
-            std::shared_ptr<ConvexPolygon> bs1 = (const std::shared_ptr<Msfl2D::ConvexPolygon> &) std::get<0>(
-                    p)->get_shapes()[0];
-            std::shared_ptr<ConvexPolygon> bs2 = (const std::shared_ptr<Msfl2D::ConvexPolygon> &) std::get<1>(
-                    p)->get_shapes()[0];
-            SATResult collision_data = CollisionDetector::sat(bs1, bs2);
 
-            if (collision_data.collide) {
+    void World::find_contact_events() {
+        contact_events.clear();
+
+        auto add_event = [this](ContactEventType type, const ContactConstraint& c) {
+            // The minimum penetration vector points towards the reference body
+            const Vec2D& n = c.result.minimum_penetration_vector;
+            contact_events.push_back({
+                type, c.body1_id, c.body2_id, c.body1_is_ref ? -n : n, c.result.depth, c.approach_speed
+            });
+        };
+
+        // Both arrays are sorted by body IDs, so they are merged in a single pass. Speculative contacts are skipped,
+        // as the bodies are not touching yet. The contacts of the last step may refer to removed bodies, so only
+        // their own values are read.
+        std::size_t i = 0;
+        std::size_t j = 0;
+        while (true) {
+            while (i < contacts.size() && contacts[i].result.is_speculative()) {i++;}
+            while (j < previous_contacts.size() && previous_contacts[j].result.is_speculative()) {j++;}
+
+            bool has_current = i < contacts.size();
+            bool has_previous = j < previous_contacts.size();
+            if (!has_current && !has_previous) {break;}
+
+            if (!has_previous || (has_current && contact_less(contacts[i], previous_contacts[j]))) {
+                add_event(ContactEventType::BEGIN, contacts[i++]);
+            }
+            else if (!has_current || contact_less(previous_contacts[j], contacts[i])) {
+                add_event(ContactEventType::END, previous_contacts[j++]);
+            }
+            else {
+                add_event(ContactEventType::PERSIST, contacts[i++]);
+                j++;
+            }
+        }
+    }
 
-                // add collision data to output arrays
-                for (int i=0; i <collision_data.nb_collision_points; i++) {
-                    if (nb_collision_points == MAX_COLLISION_POINTS) {break;}
-                    collision_points[nb_collision_points] = collision_data.collision_points[i];
-                    nb_collision_points++;
-                }
 
-                if (nb_collision_vectors != MAX_COLLISION_VECTORS && collision_data.nb_collision_points > 0) {
-                    if (collision_data.depth > 0) {
-                        Vec2D p1 = collision_data.collision_points[0];
-                        Vec2D p2 = p1 - collision_data.minimum_penetration_vector.normalized() * collision_data.depth;
-                        collision_vector[nb_collision_vectors] = LineSegment(p1, p2);
-                        nb_collision_vectors++;
-                    }
-                }
+    void World::build_islands() {
+        // Union-find over the bodies: each body starts in its own island, and the islands of the bodies
+        // connected by a contact or a joint are merged. Static & kinematic bodies are never merged, as the solver
+        // doesn't change their velocity.
+        island_parents.resize(body_storage->size());
+        for (int i=0; i<island_parents.size(); i++) {island_parents[i] = i;}
+
+        auto link = [this](const Body& b1, const Body& b2) {
+            if (!b1.is_dynamic() || !b2.is_dynamic()) {return;}
+            int root1 = find_island(b1.index);
+            int root2 = find_island(b2.index);
+            if (root1 != root2) {island_parents[root1] = root2;}
+        };
+
+        for (auto& c: contacts) {link(*c.result.ref_body, *c.result.inc_body);}
+        for (auto& j: joints) {link(*j.second->body1, *j.second->body2);}
+
+        // Each root gets an island. The constraints are added to the island of their dynamic body.
+        islands.clear();
+        FrameVector<int> island_indices(body_storage->size(), -1, ArenaAllocator<int>(frame_arena));
+        int nb_islands = 0;
+
+        auto island_of = [&](const Body& b1, const Body& b2) -> Island* {
+            const Body& body = b1.is_dynamic() ? b1 : b2;
+            if (!body.is_dynamic()) {return nullptr;}
+
+            int root = find_island(body.index);
+            if (island_indices[root] == -1) {
+                island_indices[root] = nb_islands++;
+                islands.emplace_back(frame_arena);
+            }
+            return &islands[island_indices[root]];
+        };
+
+        for (auto& c: contacts) {
+            Island* island = island_of(*c.result.ref_body, *c.result.inc_body);
+            if (island != nullptr) {island->contacts.push_back(&c);}
+        }
+        for (auto& j: joints) {
+            Island* island = island_of(*j.second->body1, *j.second->body2);
+            if (island != nullptr) {island->joints.push_back(j.second.get());}
+        }
+    }
+
 
-                CollisionResolver::resolve(collision_data, delta_t);
+    int World::find_island(int index) {
+        // Path halving: each visited body is attached to its grandparent, so the next searches are shorter
+        while (island_parents[index] != index) {
+            island_parents[index] = island_parents[island_parents[index]];
+            index = island_parents[index];
+        }
+        return index;
+    }
+
+    FrameVector<std::tuple<Body*, Body*>> World::find_pairs(real delta_t) {
+        // The bounding box of each body is expanded by its displacement during the next step, so that
+        // fast bodies are paired with the bodies they might reach before the next update.
+        FrameVector<std::tuple<AABB, Body*>> boxes{ArenaAllocator<std::tuple<AABB, Body*>>(frame_arena)};
+        boxes.reserve(bodies.size());
+        for (auto& b: bodies) {
+            if (b.second->get_shapes().empty()) {continue;}
+            boxes.emplace_back(b.second->get_aabb().expanded(b.second->get_velocity() * delta_t), b.second.get());
+        }
+
+        // Sweep and prune: once sorted along the x axis, each box only needs to be compared with the following
+        // ones, until they stop overlapping on that axis. Equal boxes are sorted by ID, so the pairs don't depend on
+        // the order of the bodies in the storage.
+        std::sort(boxes.begin(), boxes.end(), [](const auto& b1, const auto& b2) {
+            return std::make_tuple(std::get<0>(b1).min.x, std::get<1>(b1)->id) <
+                   std::make_tuple(std::get<0>(b2).min.x, std::get<1>(b2)->id);
+        });
+
+        FrameVector<std::tuple<Body*, Body*>> pairs{ArenaAllocator<std::tuple<Body*, Body*>>(frame_arena)};
+        for (int i=0; i<boxes.size(); i++) {
+            const AABB& box = std::get<0>(boxes[i]);
+            Body* body = std::get<1>(boxes[i]);
+
+            for (int j=i+1; j<boxes.size() && std::get<0>(boxes[j]).min.x <= box.max.x; j++) {
+                Body* other = std::get<1>(boxes[j]);
+
+                // Static & kinematic bodies are not affected by collisions, so they won't react to a collision
+                // with each other
+                if (!body->is_dynamic() && !other->is_dynamic()) {continue;}
+                // Bodies connected by a joint don't collide, nor do the bodies filtered out by their categories
+                if (body->is_connected(*other) || !body->can_collide(*other)) {continue;}
+                if (!AABB::overlap(box, std::get<0>(boxes[j]))) {continue;}
+
+                // The body with the lowest ID comes first, so a pair (and the key of its contact) stays the same
+                // when the bodies swap places along the x axis
+                if (body->id < other->id) {pairs.emplace_back(body, other);}
+                else {pairs.emplace_back(other, body);}
             }
         }
+
+        return pairs;
     }
 
-    double World::get_friction() const {
+
+    real World::get_friction() const {
         return friction;
     }
 
-    void World::set_friction(double f) {
+    void World::set_friction(real f) {
         if (f < 0 || f > 1) {throw SimulationException("The friction must be a value between 0 & 1");}
         friction = f;
     }
+
+    int World::get_velocity_iterations() const {
+        return velocity_iterations;
+    }
+
+    void World::set_velocity_iterations(int n) {
+        if (n < 0) {throw SimulationException("The number of velocity iterations must be >= 0");}
+        velocity_iterations = n;
+    }
+
+    int World::get_position_iterations() const {
+        return position_iterations;
+    }
+
+    void World::set_position_iterations(int n) {
+        if (n < 0) {throw SimulationException("The number of position iterations must be >= 0");}
+        position_iterations = n;
+    }
+
+    real World::get_linear_slop() const {
+        return linear_slop;
+    }
+
+    void World::set_linear_slop(real s) {
+        if (s < 0) {throw SimulationException("The linear slop must be >= 0");}
+        linear_slop = s;
+    }
 } // Msfl2D
\ No newline at end of file
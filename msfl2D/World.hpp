@@ -5,19 +5,34 @@
 #ifndef MSFL2D_WORLD_HPP
 #define MSFL2D_WORLD_HPP
 
-#include <unordered_map>
 #include <memory>
-#include <random>
+#include <cstdint>
+#include <future>
 
 #include "Body.hpp"
+#include "CollisionDetector.hpp"
+#include "CollisionResolver.hpp"
+#include "Joint.hpp"
+#include "Island.hpp"
+#include "MemoryPool.hpp"
+#include "FrameArena.hpp"
+#include "MemoryStats.hpp"
+#include "JobSystem.hpp"
+#include "WorldSnapshot.hpp"
+#include "CommandQueue.hpp"
+#include "ContactEvent.hpp"
+#include "ShapeTree.hpp"
 
 namespace Msfl2D {
 
-    typedef unsigned long BodyID;
-
     /**
      * Instance of a simulation space, containing one or more bodies and with specific parameters.
-     * The bodies are identified by a unique ID.
+     * The bodies are identified by a unique ID. They can be connected to each other by joints, also identified by
+     * a unique ID.
+     *
+     * The simulation is deterministic: the same sequence of calls gives bitwise identical results, whatever the
+     * number of threads of the JobSystem. The parallel phases only write values of their own body or pair, and the
+     * order of everything that depends on order (pairs, contacts, joints) is derived from the IDs.
      */
     class World {
     public:
@@ -25,8 +40,16 @@ namespace Msfl2D {
         static const int MAX_COLLISION_POINTS = 200;
         static const int MAX_COLLISION_VECTORS = 200;
 
+        /**
+         * Distance under which shapes produce speculative contacts, on top of the distance the bodies can travel
+         * towards each other during a step. It keeps resting contacts alive when the bodies slightly rotate.
+         */
+        static constexpr real SPECULATIVE_MARGIN = 0.02;
+
         /**
          * Number of collision points stored in the collision_points array, resulting from the last call to update()
+         * The collision points & vectors are meant for debugging: the points beyond MAX_COLLISION_POINTS are
+         * dropped. Use get_contact_events() to get every contact.
          */
         int nb_collision_points = 0;
 
@@ -49,28 +72,93 @@ namespace Msfl2D {
 
         /**
          * Force constantly applied to every body in the world. Most of the time, it's the gravity.
-         * The default value is {0, -9.8}.
+         * It is an acceleration (the same for every body, whatever its mass), applied to every dynamic body
+         * when integrating them. The default value is {0, -9.8}.
          */
         Vec2D constant_force = {0, -9.8};
 
 
 
+        /**
+         * Create an empty world, simulated on the calling thread only.
+         */
         World();
 
+        /**
+         * Create an empty world, using the given JobSystem for the parallel parts of the simulation. A JobSystem
+         * can be shared by several worlds, and may run on an executor of the host application.
+         * Throws SimulationException if the JobSystem is null.
+         */
+        explicit World(std::shared_ptr<JobSystem> job_system);
+
+        /**
+         * Destroy the world, once the step started by update_async() (if any) is done. The bodies still referenced
+         * elsewhere keep their position, velocity, etc.
+         */
+        ~World();
+
+        // The bodies of the world refer to its storage, so it can be moved but not copied. It must not be moved
+        // while it is being updated by update_async().
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+        World(World&&) = default;
+        World& operator=(World&&) = default;
+
         /**
          * Add a body to the world and return its newly created BodyID.
+         * Throws SimulationException if the body is already in a world.
          * @return
          */
         BodyID add_body(const std::shared_ptr<Body>&);
 
 
         /**
-         * Remove a body from the World.
+         * Add each of the bodies to the world, and append their newly created BodyIDs to `ids`.
+         * The memory for the bodies is reserved once. Throws SimulationException if one of the bodies is already in
+         * a world; the bodies before it are added anyway.
+         */
+        void add_bodies(const std::vector<std::shared_ptr<Body>>& new_bodies, std::vector<BodyID>& ids);
+
+        /**
+         * Create a body with no shape, allocated from the memory pool of this world, and add it to the world.
+         * Return its BodyID; use get_body() to access it. Once the pool is warm (i.e. after bodies were removed),
+         * creating a body doesn't allocate memory.
+         */
+        BodyID create_body();
+
+        /**
+         * Create `count` bodies (see create_body()), and append their BodyIDs to `ids`.
+         */
+        void create_bodies(int count, std::vector<BodyID>& ids);
+
+        /**
+         * Create a ConvexPolygon allocated from the memory pool of this world, with the arguments of one of the
+         * ConvexPolygon constructors. The polygon can be added to any body.
+         */
+        template<typename... Args>
+        std::shared_ptr<ConvexPolygon> make_polygon(Args&&... args) const {
+            return std::allocate_shared<ConvexPolygon>(PoolAllocator<ConvexPolygon>(pool), std::forward<Args>(args)...);
+        }
+
+        /**
+         * Reserve memory for the given number of bodies, so that adding bodies up to that number doesn't reallocate
+         * the arrays of the world.
+         */
+        void reserve_bodies(int nb);
+
+        /**
+         * Remove a body from the World, along with the joints attached to it.
          * Throws SimulationException if the body does not exists.
          * @param id the id of the body
          */
         void remove_body(BodyID id);
 
+        /**
+         * Remove each of the bodies from the world. Throws SimulationException if one of the bodies does not exist;
+         * the bodies before it are removed anyway.
+         */
+        void remove_bodies(const std::vector<BodyID>& ids);
+
 
         /**
          * Return a smart pointer to the body with the given id.
@@ -78,27 +166,190 @@ namespace Msfl2D {
          */
         std::shared_ptr<Body> get_body(BodyID id) const;
 
+        /**
+         * Return whether the world contains a body with the given id. Returns false for the id of a removed body.
+         */
+        bool has_body(BodyID id) const;
+
         /**
          * Return the number of bodies of the simulation
          */
         int nb_bodies() const;
 
         /**
-         * Return a read-only reference to the map containing the bodies of this world.
+         * Return a read-only reference to the array containing the bodies of this world, along with their ID.
+         * The array is packed: removing a body moves the last one in its place.
+         */
+        const CountedVector<std::pair<BodyID, std::shared_ptr<Body>>>& get_bodies() const;
+
+
+        /**
+         * Connect 2 bodies with a DistanceJoint, keeping the 2 anchors at their current distance from each other.
+         * The anchors are given in world-space coordinates.
+         * Throws SimulationException if a body does not exists, or if both IDs are the same.
+         * @return the ID of the new joint
+         */
+        JointID add_distance_joint(BodyID body1, BodyID body2, const Vec2D& anchor1, const Vec2D& anchor2);
+
+        /**
+         * Connect 2 bodies with a RevoluteJoint, rotating around the given anchor (in world-space coordinates).
+         * Throws SimulationException if a body does not exists, or if both IDs are the same.
+         * @return the ID of the new joint
+         */
+        JointID add_revolute_joint(BodyID body1, BodyID body2, const Vec2D& anchor);
+
+        /**
+         * Connect 2 bodies with a PrismaticJoint, sliding along the given axis (attached to the first body).
+         * Throws SimulationException if a body does not exists, if both IDs are the same or if the axis is null.
+         * @return the ID of the new joint
+         */
+        JointID add_prismatic_joint(BodyID body1, BodyID body2, const Vec2D& anchor, const Vec2D& axis);
+
+        /**
+         * Connect 2 bodies with a WeldJoint, pinned at the given anchor (in world-space coordinates).
+         * Throws SimulationException if a body does not exists, or if both IDs are the same.
+         * @return the ID of the new joint
+         */
+        JointID add_weld_joint(BodyID body1, BodyID body2, const Vec2D& anchor);
+
+        /**
+         * Remove a joint from the World.
+         * Throws SimulationException if the joint does not exists.
+         */
+        void remove_joint(JointID id);
+
+        /**
+         * Return a smart pointer to the joint with the given id.
+         * Throws SimulationException if the joint does not exists.
+         */
+        std::shared_ptr<Joint> get_joint(JointID id) const;
+
+        /**
+         * Return the number of joints of the simulation
+         */
+        int nb_joints() const;
+
+        /**
+         * Return the memory currently used by the world, per subsystem, along with the highest value reached by each
+         * of them. Every allocation made by the world is counted, except those of the bodies & shapes created
+         * outside of it, which belong to the user.
+         */
+        MemoryStats memory_stats() const;
+
+        /**
+         * Return a hash of the state of the bodies (IDs, positions, rotations & velocities), computed from the
+         * exact bits of the values. Two worlds with the same hash are in the same state, which makes it easy to
+         * check that a simulation replays identically.
+         */
+        std::uint64_t state_hash() const;
+
+        /**
+         * Return the JobSystem used by the world.
          */
-        const std::unordered_map<BodyID, std::shared_ptr<Body>>& get_bodies() const;
+        const std::shared_ptr<JobSystem>& get_job_system() const;
 
         /**
-         * Update the world for the given duration
+         * Update the world for the given duration. If the world is being updated by update_async(), wait for that
+         * step to be done first.
          * @param delta_t duration of the update, in seconds.
          */
-        void update(double delta_t);
+        void update(real delta_t);
+
+        /**
+         * Start updating the world for the given duration on another thread, and return a future ready once the
+         * step is done (it throws the exception thrown by the step, if any). Until then, the world must only be
+         * read through get_snapshot(); update() & update_async() wait for the step to be done.
+         *
+         * The step runs on the JobSystem of the world if it has several threads. Otherwise, a thread is created
+         * for the steps of the world the first time this is called.
+         */
+        std::future<void> update_async(real delta_t);
+
+        /**
+         * Return whether the ray going from `from` to `to` hits a shape, and set `hit` to the nearest hit if so.
+         * Rays starting inside a shape don't hit it. Like the other queries, it only reads the world, so several
+         * threads can cast rays at the same time (but not while the world is being changed or updated), and only
+         * looks for the bodies with a collision category in `mask`.
+         *
+         * The queries go through a tree of the bounding boxes of the shapes, which is rebuilt by the first query
+         * after the bodies changed (i.e. after each step).
+         */
+        bool raycast(
+                const Vec2D& from, const Vec2D& to, RaycastHit& hit, std::uint32_t mask = Body::ALL_CATEGORIES
+                ) const;
+
+        /**
+         * Append every hit of the ray going from `from` to `to` to `hits`, sorted from the nearest one. The array
+         * is only resized, so reusing it avoids allocating memory.
+         */
+        void raycast_all(
+                const Vec2D& from,
+                const Vec2D& to,
+                std::vector<RaycastHit>& hits,
+                std::uint32_t mask = Body::ALL_CATEGORIES
+                ) const;
+
+        /**
+         * Return whether the ray going from `from` to `to` hits any shape. It stops at the first shape found, so it
+         * is faster than raycast() for visibility tests.
+         */
+        bool raycast_any(const Vec2D& from, const Vec2D& to, std::uint32_t mask = Body::ALL_CATEGORIES) const;
+
+        /**
+         * Find the bodies with a shape containing the given point (or with the point on its border), and with a
+         * collision category in `mask`. Their IDs are written to `ids`, in no particular order, up to `max_ids`
+         * of them; nothing is allocated.
+         * Throws SimulationException if `max_ids` is negative, or if `ids` is null while `max_ids` is not 0.
+         * @return the number of bodies found, which may be greater than `max_ids`: the other bodies are not written.
+         */
+        int query_point(
+                const Vec2D& point, BodyID* ids, int max_ids, std::uint32_t mask = Body::ALL_CATEGORIES
+                ) const;
+
+        /**
+         * Find the bodies with a shape whose bounding box overlaps the given box, and with a collision category
+         * in `mask`. The results are written like those of query_point().
+         */
+        int query_aabb(const AABB& box, BodyID* ids, int max_ids, std::uint32_t mask = Body::ALL_CATEGORIES) const;
+
+        /**
+         * Return the contact events of the last step, in the order of the body IDs: a BEGIN or PERSIST event for
+         * each pair of bodies touching during the step, and an END event for each pair which stopped touching.
+         * The array holds every event of the step, and is reused by the next one: its memory only grows with the
+         * number of contacts. While the world is being updated by update_async(), read them from the snapshots.
+         */
+        const CountedVector<ContactEvent>& get_contact_events() const;
+
+        /**
+         * Return the queue of commands of the world. Other threads can push commands to it at any time, even while
+         * the world is being updated, instead of changing the world directly. They are executed at the start of
+         * the next step, before the forces are applied.
+         */
+        CommandQueue& get_command_queue();
+
+        /**
+         * Enable or disable the snapshots. Once enabled, a snapshot of the state of the world is published after
+         * each step, and right away.
+         */
+        void set_snapshots_enabled(bool enabled);
+
+        /**
+         * Return whether the snapshots are enabled.
+         */
+        bool get_snapshots_enabled() const;
+
+        /**
+         * Return the last snapshot published, or nullptr if the snapshots are disabled. It can be called from any
+         * thread, at any time, including while the world is being updated by update_async(): it never waits for
+         * the step, and doesn't copy the snapshot. The snapshot stays valid as long as it is referenced.
+         */
+        std::shared_ptr<const WorldSnapshot> get_snapshot() const;
 
 
         /**
          * Return the friction of the environment, i.e. the percentage of the velocity removed to the bodies each second.
          */
-        double get_friction() const;
+        real get_friction() const;
 
 
         /**
@@ -106,21 +357,258 @@ namespace Msfl2D {
          * Throws SimulationException if the value is not between 0 & 1.
          * @param f
          */
-        void set_friction(double f);
+        void set_friction(real f);
+
+
+        /**
+         * Return the number of iterations of the velocity solver, i.e. the number of times each contact & joint
+         * is visited when computing the impulses applied to the bodies.
+         */
+        int get_velocity_iterations() const;
+
+        /**
+         * Set the number of iterations of the velocity solver. More iterations make stacks & chains of joints
+         * more stable, but take more time.
+         * Throws SimulationException if the value is negative.
+         */
+        void set_velocity_iterations(int n);
+
+        /**
+         * Return the number of iterations of the position solver, i.e. the number of times each contact is visited
+         * when separating the intersecting bodies.
+         */
+        int get_position_iterations() const;
+
+        /**
+         * Set the number of iterations of the position solver. More iterations separate stacked bodies faster,
+         * but take more time.
+         * Throws SimulationException if the value is negative.
+         */
+        void set_position_iterations(int n);
+
+        /**
+         * Return the linear slop, i.e. the penetration depth allowed between 2 shapes.
+         */
+        real get_linear_slop() const;
+
+        /**
+         * Set the linear slop. Leaving the shapes slightly overlapping keeps resting contacts alive between steps,
+         * which prevents resting bodies from jittering.
+         * Throws SimulationException if the value is negative.
+         */
+        void set_linear_slop(real s);
 
 
     private:
-        std::unordered_map<BodyID, std::shared_ptr<Body>> bodies;
+        /**
+         * Entry of the sparse array of the bodies, indexed by the lower part of the BodyIDs.
+         */
+        struct BodySlot {
+            // Index of the body in the dense array, -1 if the slot is unused
+            int dense_index;
+            // Incremented each time the body of the slot is removed
+            std::uint32_t generation;
+        };
+
+        // Counters of the memory used by the world. Declared first, as the other members count their memory in it.
+        std::shared_ptr<MemoryTracker> memory;
+
+        // Bodies of the world, packed in the same order as the rows of the body storage
+        CountedVector<std::pair<BodyID, std::shared_ptr<Body>>> bodies;
+
+        // Memory of the bodies & shapes created by the world. It is shared with those objects, which may outlive
+        // the world.
+        std::shared_ptr<MemoryPool> pool;
+
+        // Slot of each BodyID, and slots left unused by removed bodies
+        CountedVector<BodySlot> body_slots;
+        CountedVector<std::uint32_t> free_body_slots;
+
+        // Values of the bodies used at each step, one row per body. It lives on the heap so that its address
+        // (known by the bodies) doesn't change when the world is moved.
+        std::unique_ptr<BodyStorage> body_storage;
+
+        // Joints of the world, sorted by ID (i.e. in the order they were added), so they are always solved in the
+        // same order
+        CountedVector<std::pair<JointID, std::shared_ptr<Joint>>> joints;
+        JointID next_joint_id = 1;
+
+        real friction = 0.1;
+
+        int velocity_iterations = 8;
+        int position_iterations = 4;
+        real linear_slop = 0.005;
+
+        // Contacts found during the current & the last update step, sorted by body IDs. The impulses of the last
+        // step are used to warm start the solver.
+        CountedVector<ContactConstraint> contacts;
+        CountedVector<ContactConstraint> previous_contacts;
+
+        // Changes of the contacts during the last step, found by comparing both arrays of contacts
+        CountedVector<ContactEvent> contact_events;
+
+        // Scheduler of the parallel parts of the simulation, possibly shared with other worlds
+        std::shared_ptr<JobSystem> job_system;
+
+        // Memory of the data only used during an update step. It is reset at the end of each step.
+        FrameArena frame_arena;
+
+        // Last snapshot of the state published, read by any thread with atomic operations, and recycler of the
+        // memory of the snapshots, null while they are disabled
+        std::shared_ptr<const WorldSnapshot> snapshot;
+        std::shared_ptr<SnapshotRecycler> snapshot_recycler;
+
+        // Commands pushed by any thread, executed at the start of each step. The queue lives on the heap, as its
+        // address must not change when the world is moved.
+        std::unique_ptr<CommandQueue> command_queue;
+
+        // Tree of the shapes used by the spatial queries. It is rebuilt by the queries (hence by const methods) when
+        // the storage of the bodies changed, and lives on the heap, as its lock can't be moved.
+        std::unique_ptr<ShapeTree> shape_tree;
+
+        // Step started by update_async(), and JobSystem running the steps when the world's own has a single thread
+        std::shared_ptr<JobSystem::Task> async_step;
+        std::shared_ptr<JobSystem> async_job_system;
+
+        // Islands of the current update step (allocated in the frame arena, and cleared at the end of the step),
+        // and scratch buffer used to build them (indexed by body row)
+        CountedVector<Island> islands;
+        CountedVector<int> island_parents;
+
+        /**
+         * Minimal number of bodies for the per-body phases (forces, integration) to run on the JobSystem, and
+         * minimal number of bodies per job. With fewer bodies, the overhead of the jobs outweighs the gain.
+         * Applying the forces is cheaper than integrating (which moves the vertices), so it needs more bodies.
+         */
+        static constexpr int PARALLEL_FORCES_THRESHOLD = 8192;
+        static constexpr int PARALLEL_INTEGRATION_THRESHOLD = 2048;
+        static constexpr int BODY_GRAIN = 512;
+
+        /**
+         * Minimal number of pairs for the narrow phase to run on the JobSystem, and minimal number of pairs per job.
+         */
+        static constexpr int PARALLEL_NARROWPHASE_THRESHOLD = 256;
+        static constexpr int PAIR_GRAIN = 64;
+
+        // Scratch buffer of the position solver, indexed by the row of the bodies in the storage.
+        CountedVector<Vec2D> position_deltas;
+
+        /**
+         * Return the index of the body in the dense array, or -1 if the id does not refer to a body of the world.
+         */
+        int find_body(BodyID id) const;
+
+        /**
+         * Return the index of the joint with the given ID in the joints array, or -1 if there is no such joint.
+         */
+        int find_joint(JointID id) const;
+
+        /**
+         * Give a BodyID to a body attached to the storage of the world, and add it to the dense array.
+         */
+        BodyID insert_body(const std::shared_ptr<Body>& body);
+
+        /**
+         * Take the body out of the storage of the world. Its values are only kept if it is referenced elsewhere.
+         */
+        static void release_body(const std::shared_ptr<Body>& body);
+
+        /**
+         * Broad phase of the collision detection: return the pairs of bodies whose bounding boxes, expanded by
+         * their displacement during the next step, are overlapping. Only those pairs may collide.
+         */
+        FrameVector<std::tuple<Body*, Body*>> find_pairs(real delta_t);
+
+        /**
+         * Create a joint of type T, counting its memory.
+         */
+        template<typename T, typename... Args>
+        std::shared_ptr<Joint> make_joint(Args&&... args);
+
+        /**
+         * Register a newly created joint to the World and to its bodies.
+         */
+        JointID add_joint(const std::shared_ptr<Joint>& joint);
+
+        /**
+         * Check that both bodies can be connected by a joint, and return them.
+         * Throws SimulationException if a body does not exists, or if both IDs are the same.
+         */
+        std::pair<std::shared_ptr<Body>, std::shared_ptr<Body>> get_joint_bodies(BodyID body1, BodyID body2) const;
 
-        // random number generator
-        std::mt19937 rng_gen;
+        /**
+         * Update the world for the given duration (see update()), without waiting for the step started by
+         * update_async().
+         */
+        void update_step(real delta_t);
 
-        double friction = 0.1;
+        /**
+         * Return the tree of the shapes, rebuilt if the bodies changed since it was built.
+         */
+        const ShapeTree& get_shape_tree() const;
+
+        /**
+         * Check the buffer given to a query. Throws SimulationException if it is invalid (see query_point()).
+         */
+        static void check_query_buffer(const BodyID* ids, int max_ids);
+
+        /**
+         * Execute the commands pushed to the command queue since the last step.
+         */
+        void execute_commands();
+
+        /**
+         * Wait for the step started by update_async() to be done, if any.
+         */
+        void wait_async_step();
+
+        /**
+         * Return the JobSystem running the steps started by update_async().
+         */
+        JobSystem& get_async_job_system();
+
+        /**
+         * Write the state of the world to a new snapshot, and publish it in place of the last one.
+         */
+        void publish_snapshot();
+
+        /**
+         * Apply the registered forces, the constant force & the friction of the environment to the velocity of
+         * the dynamic bodies, then reset their forces.
+         */
+        void apply_forces(real delta_t);
+
+        /**
+         * Call function(first, last) over the rows of the body storage, on the JobSystem if there are at least
+         * `threshold` bodies, on the calling thread otherwise.
+         */
+        template<typename F>
+        void for_each_body(int threshold, const F& function);
+
+        /**
+         * Move & rotate the bodies according to their velocity & angular velocity.
+         */
+        void integrate(real delta_t);
+
+        /**
+         * Copy the impulses of the contacts of the last step to the matching contacts of the current step.
+         */
+        void warm_start_contacts();
+
+        /**
+         * Compare the contacts of the current step with those of the last step, and fill contact_events.
+         */
+        void find_contact_events();
+
+        /**
+         * Group the contacts & joints into islands of bodies interacting with each other.
+         */
+        void build_islands();
 
         /**
-         * Return a new unused BodyID.
+         * Return the root of the island containing the body with the given row, in island_parents.
          */
-        BodyID new_id();
+        int find_island(int index);
     };
 
 } // Msfl2D
@@ -0,0 +1,80 @@
+//
+// Created by myselfleo on 29/07/2023.
+//
+
+#include "WorldBatch.hpp"
+#include "MsflExceptions.hpp"
+
+namespace Msfl2D {
+    WorldBatch::WorldBatch(std::shared_ptr<JobSystem> job_system):
+        job_system(std::move(job_system)),
+        world_job_system(std::make_shared<JobSystem>(1))
+        {
+        if (this->job_system == nullptr) {throw SimulationException("The JobSystem of a world batch can't be null");}
+    }
+
+
+    int WorldBatch::add_world() {
+        worlds.push_back(std::make_unique<World>(world_job_system));
+        outputs.resize(worlds.size() * nb_outputs, 0);
+        return worlds.size() - 1;
+    }
+
+    void WorldBatch::add_worlds(int count) {
+        worlds.reserve(worlds.size() + count);
+        for (int i=0; i<count; i++) {worlds.push_back(std::make_unique<World>(world_job_system));}
+        outputs.resize(worlds.size() * nb_outputs, 0);
+    }
+
+    World &WorldBatch::get_world(int index) {
+        if (index < 0 || index >= worlds.size()) {throw SimulationException("Tried to access inexistant world");}
+        return *worlds[index];
+    }
+
+    const World &WorldBatch::get_world(int index) const {
+        if (index < 0 || index >= worlds.size()) {throw SimulationException("Tried to access inexistant world");}
+        return *worlds[index];
+    }
+
+    int WorldBatch::nb_worlds() const {
+        return worlds.size();
+    }
+
+
+    void WorldBatch::set_output(int nb_values, Output function) {
+        if (nb_values < 0) {throw SimulationException("The number of outputs of a world must be >= 0");}
+        nb_outputs = nb_values;
+        output = std::move(function);
+        outputs.assign(worlds.size() * nb_outputs, 0);
+    }
+
+    int WorldBatch::get_nb_outputs() const {
+        return nb_outputs;
+    }
+
+    const std::vector<real> &WorldBatch::get_outputs() const {
+        return outputs;
+    }
+
+    const real *WorldBatch::get_outputs(int index) const {
+        if (index < 0 || index >= worlds.size()) {throw SimulationException("Tried to access inexistant world");}
+        return outputs.data() + index * nb_outputs;
+    }
+
+
+    void WorldBatch::step(real delta_t, int nb_steps) {
+        if (nb_steps < 0) {throw SimulationException("The number of steps must be >= 0");}
+
+        // One world per job: the worlds may take very different times to step, so the threads are better balanced
+        // by stealing worlds one by one
+        job_system->parallel_for_each(0, worlds.size(), [&](int i) {
+            World& world = *worlds[i];
+            for (int s=0; s<nb_steps; s++) {world.update(delta_t);}
+            if (output && nb_outputs > 0) {output(world, i, outputs.data() + i * nb_outputs);}
+        });
+    }
+
+    const std::shared_ptr<JobSystem> &WorldBatch::get_job_system() const {
+        return job_system;
+    }
+} // Msfl2D
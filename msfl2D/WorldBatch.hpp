@@ -0,0 +1,124 @@
+//
+// Created by myselfleo on 29/07/2023.
+//
+
+#ifndef MSFL2D_WORLDBATCH_HPP
+#define MSFL2D_WORLDBATCH_HPP
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "World.hpp"
+#include "JobSystem.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * Set of independent worlds, stepped together in parallel. It is meant for ensembles of many small worlds (like
+     * the runs of a Monte Carlo simulation), too small to be worth splitting across threads on their own.
+     *
+     * The unit of work is a whole world: each world is stepped by a single thread, from the beginning to the end of
+     * a call to step(), so the threads never have to synchronize within a world. The worlds are spread over the
+     * threads of the JobSystem of the batch, idle threads stealing the worlds not stepped yet.
+     *
+     * After each call to step(), an output function can extract values from each world into a single contiguous
+     * array, with one row of values per world.
+     */
+    class WorldBatch {
+    public:
+        /**
+         * Function writing the values extracted from a world to `values`, an array of get_nb_outputs() values.
+         * It is called from the thread which stepped the world, so it may run for several worlds at once.
+         */
+        typedef std::function<void(const World& world, int world_index, real* values)> Output;
+
+        /**
+         * Create an empty batch, stepping its worlds on the given JobSystem.
+         * Throws SimulationException if the JobSystem is null.
+         */
+        explicit WorldBatch(std::shared_ptr<JobSystem> job_system = std::make_shared<JobSystem>());
+
+        WorldBatch(const WorldBatch&) = delete;
+        WorldBatch& operator=(const WorldBatch&) = delete;
+
+        /**
+         * Create an empty world at the end of the batch, and return its index. The world is simulated on the thread
+         * stepping it only.
+         */
+        int add_world();
+
+        /**
+         * Create `count` empty worlds at the end of the batch.
+         */
+        void add_worlds(int count);
+
+        /**
+         * Return the world with the given index, to add its bodies or change its parameters. It must not be used
+         * while the batch is being stepped.
+         * Throws SimulationException if there is no world with this index.
+         */
+        World& get_world(int index);
+        const World& get_world(int index) const;
+
+        /**
+         * Return the number of worlds of the batch.
+         */
+        int nb_worlds() const;
+
+        /**
+         * Set the function extracting `nb_values` values from each world after each step. The outputs are resized
+         * to hold one row per world.
+         * Throws SimulationException if the number of values is negative.
+         */
+        void set_output(int nb_values, Output function);
+
+        /**
+         * Return the number of values extracted from each world.
+         */
+        int get_nb_outputs() const;
+
+        /**
+         * Return the values extracted after the last step, one row of get_nb_outputs() values per world, in the
+         * order of the worlds. The rows of the worlds added since the last step are filled with 0.
+         */
+        const std::vector<real>& get_outputs() const;
+
+        /**
+         * Return the row of values extracted from the world with the given index after the last step.
+         * Throws SimulationException if there is no world with this index.
+         */
+        const real* get_outputs(int index) const;
+
+        /**
+         * Update each world `nb_steps` times with the given duration, in parallel. The outputs of each world are
+         * extracted right after its last update, by the same thread.
+         * If the update of a world throws, the worlds not started yet are not stepped (and their outputs are left
+         * unchanged), and the first exception is thrown again once the worlds being stepped are done.
+         * Throws SimulationException if the number of steps is negative.
+         */
+        void step(real delta_t, int nb_steps = 1);
+
+        /**
+         * Return the JobSystem stepping the worlds.
+         */
+        const std::shared_ptr<JobSystem>& get_job_system() const;
+
+    private:
+        std::shared_ptr<JobSystem> job_system;
+
+        // JobSystem of the worlds themselves: it runs everything on the calling thread, so a world never waits
+        // for another thread
+        std::shared_ptr<JobSystem> world_job_system;
+
+        // The worlds are allocated separately, so the references returned by get_world() stay valid
+        std::vector<std::unique_ptr<World>> worlds;
+
+        int nb_outputs = 0;
+        Output output;
+        std::vector<real> outputs;
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_WORLDBATCH_HPP
@@ -0,0 +1,51 @@
+//
+// Created by myselfleo on 30/07/2023.
+//
+
+#include "WorldSnapshot.hpp"
+
+namespace Msfl2D {
+    SnapshotRecycler::SnapshotRecycler(std::shared_ptr<MemoryCounter> counter): counter(std::move(counter)) {}
+
+    SnapshotRecycler::~SnapshotRecycler() {
+        // The snapshots & their blocks keep the recycler alive, so what is left here was released
+        WorldSnapshot* snapshot = free_snapshot.load(std::memory_order_acquire);
+        if (snapshot != nullptr) {
+            delete snapshot;
+            counter->remove(sizeof(WorldSnapshot));
+        }
+
+        void* block = free_block.load(std::memory_order_acquire);
+        if (block != nullptr) {
+            ::operator delete(block);
+            counter->remove(block_size.load(std::memory_order_relaxed));
+        }
+    }
+
+    std::shared_ptr<WorldSnapshot> SnapshotRecycler::make_snapshot() {
+        WorldSnapshot* snapshot = free_snapshot.exchange(nullptr, std::memory_order_acquire);
+        if (snapshot == nullptr) {
+            snapshot = new WorldSnapshot(counter);
+            counter->add(sizeof(WorldSnapshot));
+        }
+        else {
+            snapshot->bodies.clear();
+            snapshot->shapes.clear();
+            snapshot->vertices.clear();
+            snapshot->contacts.clear();
+            snapshot->contact_events.clear();
+        }
+
+        // If the control block can't be allocated, the shared_ptr gives the snapshot to the deleter
+        std::shared_ptr<SnapshotRecycler> self = shared_from_this();
+        return {snapshot, SnapshotDeleter{self}, SnapshotAllocator<WorldSnapshot>(self)};
+    }
+
+    void SnapshotRecycler::release(WorldSnapshot *snapshot) {
+        WorldSnapshot* expected = nullptr;
+        if (free_snapshot.compare_exchange_strong(expected, snapshot, std::memory_order_release)) {return;}
+
+        delete snapshot;
+        counter->remove(sizeof(WorldSnapshot));
+    }
+} // Msfl2D
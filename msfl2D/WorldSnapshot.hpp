@@ -0,0 +1,192 @@
+//
+// Created by myselfleo on 30/07/2023.
+//
+
+#ifndef MSFL2D_WORLDSNAPSHOT_HPP
+#define MSFL2D_WORLDSNAPSHOT_HPP
+
+#include <atomic>
+#include <memory>
+
+#include "Body.hpp"
+#include "Transform2D.hpp"
+#include "MemoryStats.hpp"
+#include "ContactEvent.hpp"
+
+namespace Msfl2D {
+
+    /**
+     * State of a body at the end of a step.
+     * @param first_shape Index of the first shape of the body in WorldSnapshot::shapes. Its shapes are consecutive.
+     */
+    struct BodySnapshot {
+        BodyID id;
+        Vec2D position;
+        Rotor2D rotation;
+        Vec2D velocity;
+        real angular_velocity;
+        real mass;
+        bool is_dynamic;
+        int nb_collisions;
+        int first_shape;
+        int nb_shapes;
+    };
+
+    /**
+     * Shape of a body at the end of a step.
+     * @param position Center of the shape, in world-space coordinates
+     * @param first_vertex Index of the first vertex of the shape in WorldSnapshot::vertices. Its vertices are
+     *                     consecutive, in world-space coordinates. Shapes without vertices have nb_vertices = 0.
+     */
+    struct ShapeSnapshot {
+        Vec2D position;
+        int first_vertex;
+        int nb_vertices;
+    };
+
+    /**
+     * Contact solved during a step.
+     * @param normal Direction of the contact, normalized (see SATResult::minimum_penetration_vector)
+     * @param depth Penetration depth; it is negative for speculative contacts, which are not touching yet.
+     */
+    struct ContactSnapshot {
+        BodyID body1_id;
+        BodyID body2_id;
+        Vec2D normal;
+        real depth;
+        int nb_points;
+        Vec2D points[2];
+    };
+
+
+    /**
+     * Read-only copy of the state of a World at the end of a step: the transforms & velocities of its bodies, the
+     * world-space vertices of their shapes, and the contacts & contact events of the step. See World::get_snapshot().
+     *
+     * The snapshots are immutable once published, so any thread can read them while the world is being stepped.
+     */
+    struct WorldSnapshot {
+        /** Bodies, in the same order as World::get_bodies() */
+        CountedVector<BodySnapshot> bodies;
+        CountedVector<ShapeSnapshot> shapes;
+        CountedVector<Vec2D> vertices;
+        CountedVector<ContactSnapshot> contacts;
+        /** Contact events of the step (see World::get_contact_events()) */
+        CountedVector<ContactEvent> contact_events;
+
+        /**
+         * Create an empty snapshot, whose memory is counted in the given counter.
+         */
+        explicit WorldSnapshot(const std::shared_ptr<MemoryCounter>& counter):
+            bodies(CountingAllocator<BodySnapshot>(counter)),
+            shapes(CountingAllocator<ShapeSnapshot>(counter)),
+            vertices(CountingAllocator<Vec2D>(counter)),
+            contacts(CountingAllocator<ContactSnapshot>(counter)),
+            contact_events(CountingAllocator<ContactEvent>(counter))
+            {}
+    };
+
+
+    /**
+     * Creates the snapshots of a world, and recycles their memory: a snapshot released by its last reader is kept,
+     * along with the memory of its shared_ptr, to be written again. Since the world only writes a new snapshot while
+     * the last one is published, two snapshots are enough once warm (more if the readers keep them), and publishing
+     * a snapshot doesn't allocate memory.
+     *
+     * The snapshots can be released from any thread. They keep the recycler alive, as they may outlive the world.
+     */
+    class SnapshotRecycler: public std::enable_shared_from_this<SnapshotRecycler> {
+    public:
+        /**
+         * Create a recycler counting the memory of the snapshots in the given counter.
+         */
+        explicit SnapshotRecycler(std::shared_ptr<MemoryCounter> counter);
+
+        ~SnapshotRecycler();
+
+        SnapshotRecycler(const SnapshotRecycler&) = delete;
+        SnapshotRecycler& operator=(const SnapshotRecycler&) = delete;
+
+        /**
+         * Return an empty snapshot, reusing the memory of a released one if possible.
+         */
+        std::shared_ptr<WorldSnapshot> make_snapshot();
+
+    private:
+        template<typename T> friend class SnapshotAllocator;
+        friend struct SnapshotDeleter;
+
+        std::shared_ptr<MemoryCounter> counter;
+
+        // Snapshot released by its last reader, and memory of the control block of its shared_ptr. The releasing
+        // thread stores them with release semantics, so the snapshot can be written once taken back.
+        std::atomic<WorldSnapshot*> free_snapshot{nullptr};
+        std::atomic<void*> free_block{nullptr};
+        std::atomic<std::size_t> block_size{0};
+
+        /**
+         * Keep a released snapshot, or destroy it if one is already kept.
+         */
+        void release(WorldSnapshot* snapshot);
+    };
+
+
+    /**
+     * Deleter of the snapshots, giving them back to their recycler.
+     */
+    struct SnapshotDeleter {
+        std::shared_ptr<SnapshotRecycler> recycler;
+
+        void operator()(WorldSnapshot* snapshot) const {
+            recycler->release(snapshot);
+        }
+    };
+
+
+    /**
+     * Allocator of the control blocks of the snapshots' shared_ptrs, reusing the block of a released snapshot.
+     * The control blocks all have the same type, hence the same size.
+     */
+    template<typename T>
+    class SnapshotAllocator {
+    public:
+        typedef T value_type;
+
+        explicit SnapshotAllocator(std::shared_ptr<SnapshotRecycler> recycler): recycler(std::move(recycler)) {}
+
+        template<typename U>
+        SnapshotAllocator(const SnapshotAllocator<U>& other): recycler(other.recycler) {} // NOLINT(google-explicit-constructor)
+
+        T* allocate(std::size_t n) {
+            void* block = recycler->free_block.exchange(nullptr, std::memory_order_acquire);
+            if (block != nullptr) {return static_cast<T*>(block);}
+
+            block = ::operator new(n * sizeof(T));
+            recycler->counter->add(n * sizeof(T));
+            recycler->block_size.store(n * sizeof(T), std::memory_order_relaxed);
+            return static_cast<T*>(block);
+        }
+
+        void deallocate(T* p, std::size_t n) {
+            void* expected = nullptr;
+            if (recycler->free_block.compare_exchange_strong(expected, p, std::memory_order_release)) {return;}
+
+            ::operator delete(p);
+            recycler->counter->remove(n * sizeof(T));
+        }
+
+        template<typename U>
+        bool operator==(const SnapshotAllocator<U>& other) const {return recycler == other.recycler;}
+
+        template<typename U>
+        bool operator!=(const SnapshotAllocator<U>& other) const {return recycler != other.recycler;}
+
+    private:
+        template<typename U> friend class SnapshotAllocator;
+
+        std::shared_ptr<SnapshotRecycler> recycler;
+    };
+
+} // Msfl2D
+
+#endif //MSFL2D_WORLDSNAPSHOT_HPP